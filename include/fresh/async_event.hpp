@@ -0,0 +1,279 @@
+//
+// async_event.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_async_event_hpp
+#define fresh_async_event_hpp
+
+#include "config.hpp"
+#include "event.hpp"
+#include "executor.hpp"
+#include "event_details/bounded_queue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    // What post() does when an async_event's queue is full.
+    enum class backpressure
+    {
+        // Wait for the executor to make room.
+        block,
+
+        // Discard the oldest queued emission.
+        drop_oldest,
+
+        // Replace the newest emission which hasn't been queued yet, so that
+        // only the latest arguments are delivered once there's room.
+        coalesce
+    };
+
+    template <class FnType,
+        template <class T> class Alloc = std::allocator,
+        class Combiner = typename default_combiner<FnType, Alloc>::type,
+        class Locking = default_locking>
+    class async_event;
+
+    FRESH_END_NAMESPACE
+}
+
+// A thread-safe event which can also be emitted asynchronously. post() copies
+// its arguments into a bounded lock-free queue and returns; the queue is then
+// drained on an executor, up to batch_size emissions per task, in the order
+// they were posted. Emitting with operator() still calls every slot on the
+// calling thread.
+//
+// If a slot throws, the rest of that emission's slots aren't called, as with
+// operator(), and the exception is passed on to the executor. The emissions
+// after it are delivered by the next task.
+//
+// Destroying an async_event waits for everything that has been posted to be
+// delivered, so it must not be destroyed from one of its own slots.
+template <template <class T> class Alloc,
+    class Combiner,
+    class Locking,
+    class Result,
+    class... Args>
+class fresh::async_event<Result(Args...), Alloc, Combiner, Locking> :
+    public event<Result(Args...), true, Alloc, Combiner, Locking>
+{
+    static_assert(is_thread_safe_function_type<Result(Args...)>::value,
+        "Async events require a function type that passes and returns by copy.");
+
+public:
+
+    using base = event<Result(Args...), true, Alloc, Combiner, Locking>;
+    using allocator_type = typename base::allocator_type;
+
+    static const size_t default_capacity = 1024;
+    static const size_t default_batch_size = 64;
+
+    async_event(executor& exec = thread_pool::shared(),
+                size_t capacity = default_capacity,
+                backpressure policy = backpressure::block,
+                size_t batch_size = default_batch_size,
+                const allocator_type& alloc = allocator_type()) :
+        base(alloc),
+        _executor(exec),
+        _queue(capacity, alloc),
+        _policy(policy),
+        _batch_size(batch_size > 0 ? batch_size : 1)
+    {
+    }
+
+    async_event(const async_event& other) = delete;
+
+    ~async_event()
+    {
+        flush();
+
+        while (_drains.load() > 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    async_event& operator= (const async_event& other) = delete;
+
+    // With backpressure::block, a slot of this event posting to it may wait
+    // forever if the queue is full.
+    void post(Args... args)
+    {
+        enqueue(emission_type(std::move(args)...));
+        schedule();
+    }
+
+    // Waits until everything posted so far has been delivered.
+    void flush()
+    {
+        while (pending() || _scheduled.load())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // The number of emissions discarded or coalesced because the queue was
+    // full.
+    size_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    using emission_type = std::tuple<typename std::decay<Args>::type...>;
+    using queue_type = event_details::bounded_queue<emission_type, Alloc>;
+
+    void enqueue(emission_type&& emission)
+    {
+        switch (_policy)
+        {
+            case backpressure::block:
+
+                while (!_queue.try_push(std::move(emission)))
+                {
+                    schedule();
+                    std::this_thread::yield();
+                }
+
+                break;
+
+            case backpressure::drop_oldest:
+
+                while (!_queue.try_push(std::move(emission)))
+                {
+                    if (_queue.try_pop([](emission_type&&) {}))
+                    {
+                        _dropped.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+
+                break;
+
+            case backpressure::coalesce:
+
+                // Once an emission has been coalesced, later ones must be too
+                // or they'd overtake it.
+                if (_coalescing.load() || !_queue.try_push(std::move(emission)))
+                {
+                    std::lock_guard<std::mutex> lock(_latest_mutex);
+
+                    if (_latest)
+                    {
+                        _dropped.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    _latest = std::move(emission);
+                    _coalescing.store(true);
+                }
+
+                break;
+        }
+    }
+
+    bool pending() const
+    {
+        return !_queue.empty() || _coalescing.load();
+    }
+
+    void schedule()
+    {
+        if (!_scheduled.exchange(true))
+        {
+            _drains.fetch_add(1);
+            _executor.execute([this]() { drain(); });
+        }
+    }
+
+    void drain()
+    {
+        try
+        {
+            deliver_batch();
+        }
+        catch (...)
+        {
+            finish_drain();
+            throw;
+        }
+
+        finish_drain();
+    }
+
+    void deliver_batch()
+    {
+        size_t delivered = 0;
+
+        while (delivered < _batch_size &&
+               _queue.try_pop([this](emission_type&& emission) { deliver(emission); }))
+        {
+            ++delivered;
+        }
+
+        if (delivered < _batch_size && _coalescing.load())
+        {
+            std::optional<emission_type> latest;
+
+            {
+                std::lock_guard<std::mutex> lock(_latest_mutex);
+
+                if (_queue.empty())
+                {
+                    latest = std::move(_latest);
+                    _latest.reset();
+                    _coalescing.store(false);
+                }
+            }
+
+            if (latest)
+            {
+                deliver(*latest);
+            }
+        }
+    }
+
+    void finish_drain()
+    {
+        // Give other tasks on the executor a turn between batches.
+        _scheduled.store(false);
+
+        if (pending())
+        {
+            schedule();
+        }
+
+        // This must be the last use of the event, which may be destroyed as
+        // soon as it's done.
+        _drains.fetch_sub(1);
+    }
+
+    void deliver(emission_type& emission)
+    {
+        std::apply([this](auto&... args) { (*this)(args...); }, emission);
+    }
+
+    executor&                       _executor;
+    queue_type                      _queue;
+    const backpressure              _policy;
+    const size_t                    _batch_size;
+    std::atomic<bool>               _scheduled {false};
+    std::atomic<unsigned>           _drains {0};
+    std::atomic<size_t>             _dropped {0};
+    std::atomic<bool>               _coalescing {false};
+    std::mutex                      _latest_mutex;
+    std::optional<emission_type>    _latest;
+};
+
+#endif
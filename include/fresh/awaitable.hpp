@@ -0,0 +1,339 @@
+//
+// awaitable.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_awaitable_hpp
+#define fresh_awaitable_hpp
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+    #if __has_include(<coroutine>)
+
+        #define FRESH_COROUTINES 1
+
+    #endif
+#endif
+
+#ifndef FRESH_COROUTINES
+
+    #define FRESH_COROUTINES 0
+
+#endif
+
+#if FRESH_COROUTINES
+
+#include "config.hpp"
+#include "connection.hpp"
+#include "event.hpp"
+#include "executor.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    template <class Event>
+    class event_awaiter;
+
+    template <class T, bool ThreadSafe = false>
+    class event_stream;
+
+    namespace event_details
+    {
+        template <class FnType>
+        struct awaited;
+
+        inline void resume(std::coroutine_handle<> handle, executor* exec)
+        {
+            if (exec)
+            {
+                exec->execute([handle]() { handle.resume(); });
+            }
+            else
+            {
+                handle.resume();
+            }
+        }
+    }
+
+    // co_await e suspends until e's next emission, and gives its arguments:
+    // nothing for void(), the argument for one, or a tuple of them for more.
+    // The coroutine is resumed on the emitting thread.
+    template <class FnType, bool ThreadSafe, template <class T> class Alloc, class Combiner,
+        class Locking>
+    event_awaiter<event<FnType, ThreadSafe, Alloc, Combiner, Locking>>
+    operator co_await (event<FnType, ThreadSafe, Alloc, Combiner, Locking>& e)
+    {
+        return event_awaiter<event<FnType, ThreadSafe, Alloc, Combiner, Locking>>(e, nullptr);
+    }
+
+    // Like co_await e, but the coroutine is resumed on exec.
+    template <class Event>
+    event_awaiter<Event> next_emission(Event& e, executor& exec)
+    {
+        return event_awaiter<Event>(e, &exec);
+    }
+
+    // Queues every emission of e from now on, for a coroutine to await one
+    // at a time.
+    template <class Event>
+    auto emissions(Event& e, executor* exec = nullptr)
+    {
+        using awaited = event_details::awaited<typename Event::function_type>;
+
+        static_assert(!std::is_void<typename awaited::type>::value,
+            "Streams need an event with arguments; await the event itself instead.");
+
+        return event_stream<typename awaited::type,
+            std::is_same<typename Event::connection_type, connection<true>>::value>(
+                e, [](const auto&... args) { return awaited::make(args...); }, exec);
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+template <class Result, class... Args>
+struct fresh::event_details::awaited<Result(Args...)>
+{
+    using type = std::tuple<typename std::decay<Args>::type...>;
+
+    template <class... A>
+    static type make(const A&... args)
+    {
+        return type(args...);
+    }
+};
+
+template <class Result, class Arg>
+struct fresh::event_details::awaited<Result(Arg)>
+{
+    using type = typename std::decay<Arg>::type;
+
+    static type make(const type& arg)
+    {
+        return arg;
+    }
+};
+
+template <class Result>
+struct fresh::event_details::awaited<Result()>
+{
+    using type = void;
+};
+
+// Awaits a single emission. It connects a slot when the coroutine suspends,
+// and disconnects it once the coroutine is resumed or destroyed. Should the
+// emission arrive before the coroutine has finished suspending, it carries
+// on without suspending.
+template <class Event>
+class fresh::event_awaiter
+{
+    using awaited = event_details::awaited<typename Event::function_type>;
+
+public:
+
+    using value_type = typename awaited::type;
+
+    event_awaiter(Event& e, executor* exec) :
+        _event(e),
+        _executor(exec)
+    {
+    }
+
+    event_awaiter(const event_awaiter& other) = delete;
+
+    event_awaiter& operator= (const event_awaiter& other) = delete;
+
+    bool await_ready() const
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        _handle = handle;
+
+        // Once the slot has resumed the coroutine, this may have been
+        // destroyed, so it mustn't be touched.
+        _connection = _event.connect(
+            [this](const auto&... args)
+            {
+                if (_claimed.exchange(true))
+                {
+                    return;
+                }
+
+                if constexpr (!std::is_void<value_type>::value)
+                {
+                    _value.emplace(awaited::make(args...));
+                }
+
+                if (_state.exchange(fired) == suspended)
+                {
+                    event_details::resume(_handle, _executor);
+                }
+            });
+
+        return _state.exchange(suspended) != fired;
+    }
+
+    value_type await_resume()
+    {
+        _connection.disconnect();
+
+        if constexpr (!std::is_void<value_type>::value)
+        {
+            return std::move(*_value);
+        }
+    }
+
+private:
+
+    enum state
+    {
+        connecting,
+        suspended,
+        fired
+    };
+
+    using value_storage = typename std::conditional<std::is_void<value_type>::value,
+        bool, std::optional<value_type>>::type;
+
+    Event&                              _event;
+    executor*                           _executor;
+    std::coroutine_handle<>             _handle;
+    typename Event::connection_type     _connection;
+    value_storage                       _value {};
+    std::atomic<bool>                   _claimed {false};
+    std::atomic<int>                    _state {connecting};
+};
+
+// A queue of values, one per emission of whatever it's connected to, for a
+// single coroutine to take in order with co_await stream.next(). A single
+// slot stays connected for the stream's lifetime, so awaiting doesn't connect
+// anything. If values are already queued, next() doesn't suspend; otherwise
+// the coroutine is resumed by the next emission, on the stream's executor if
+// it has one.
+template <class T, bool ThreadSafe>
+class fresh::event_stream
+{
+public:
+
+    class awaiter
+    {
+    public:
+
+        awaiter(event_stream& stream) :
+            _stream(stream)
+        {
+        }
+
+        bool await_ready() const
+        {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            return _stream.suspend(handle);
+        }
+
+        T await_resume()
+        {
+            return _stream.pop();
+        }
+
+    private:
+
+        event_stream& _stream;
+    };
+
+    // Connects to source, queuing to_value(args...) for each emission.
+    template <class Source, class ToValue>
+    event_stream(Source& source, ToValue to_value, executor* exec) :
+        _executor(exec),
+        _connection(source.connect(
+            [this, to_value](const auto&... args)
+            {
+                push(to_value(args...));
+            }))
+    {
+    }
+
+    event_stream(const event_stream& other) = delete;
+
+    event_stream& operator= (const event_stream& other) = delete;
+
+    awaiter next()
+    {
+        return awaiter(*this);
+    }
+
+    // How many values are queued.
+    size_t pending() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _values.size();
+    }
+
+private:
+
+    void push(T value)
+    {
+        std::coroutine_handle<> waiting;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _values.push_back(std::move(value));
+            std::swap(waiting, _waiting);
+        }
+
+        if (waiting)
+        {
+            event_details::resume(waiting, _executor);
+        }
+    }
+
+    bool suspend(std::coroutine_handle<> handle)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (!_values.empty())
+        {
+            return false;
+        }
+
+        _waiting = handle;
+        return true;
+    }
+
+    T pop()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        T value = std::move(_values.front());
+        _values.pop_front();
+
+        return value;
+    }
+
+    mutable std::mutex          _mutex;
+    std::deque<T>               _values;
+    std::coroutine_handle<>     _waiting;
+    executor*                   _executor;
+    connection<ThreadSafe>      _connection;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+//
+// batch.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_batch_hpp
+#define fresh_batch_hpp
+
+#include "config.hpp"
+#include "delegate.hpp"
+#include "event_details/allocation.hpp"
+#include "event_details/traits.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    template <class FnType>
+    class batch;
+
+    namespace event_details
+    {
+        template <class FnType, class Allocator>
+        class batch_slot;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// A view of the arguments of several emissions, one tuple each, for
+// event::emit_batch and the slots connected with event::connect_batch. It
+// doesn't own them, so it's only valid for as long as they are.
+template <class... Args>
+class fresh::batch<void(Args...)>
+{
+public:
+
+    using value_type = std::tuple<typename std::decay<Args>::type...>;
+    using const_iterator = const value_type*;
+
+    batch(const value_type* items, size_t count) :
+        _items(items),
+        _count(count)
+    {
+    }
+
+    // Views a contiguous container, such as a vector or array, of tuples.
+    template <class Container,
+        class = typename std::enable_if<std::is_convertible<
+            decltype(std::declval<const Container&>().data()), const value_type*>::value>::type>
+    batch(const Container& items) :
+        _items(items.data()),
+        _count(items.size())
+    {
+    }
+
+    const_iterator begin() const
+    {
+        return _items;
+    }
+
+    const_iterator end() const
+    {
+        return _items + _count;
+    }
+
+    size_t size() const
+    {
+        return _count;
+    }
+
+    bool empty() const
+    {
+        return _count == 0;
+    }
+
+    const value_type& operator[] (size_t index) const
+    {
+        return _items[index];
+    }
+
+private:
+
+    const value_type*   _items;
+    size_t              _count;
+};
+
+// The callable of a slot connected with connect_batch. It's small enough for
+// a delegate to hold inline, so the event can find it with delegate::target
+// and hand it a whole batch. A single emission is handed over as a batch of
+// one.
+template <class Allocator, class... Args>
+class fresh::event_details::batch_slot<void(Args...), Allocator>
+{
+public:
+
+    using batch_type = batch<void(Args...)>;
+
+    template <class Fn>
+    batch_slot(const Allocator& alloc, Fn&& fn) :
+        _block(allocate_object<block>(alloc, alloc,
+            delegate<void(const batch_type&)>(std::allocator_arg, alloc, std::forward<Fn>(fn))))
+    {
+    }
+
+    batch_slot(const batch_slot& other) = delete;
+
+    batch_slot(batch_slot&& other) noexcept :
+        _block(other._block)
+    {
+        other._block = nullptr;
+    }
+
+    ~batch_slot()
+    {
+        if (_block)
+        {
+            destroy_object(_block->alloc, _block);
+        }
+    }
+
+    batch_slot& operator= (const batch_slot& other) = delete;
+
+    void operator() (param_type<Args>... args) const
+    {
+        typename batch_type::value_type item(args...);
+
+        _block->fn(batch_type(&item, 1));
+    }
+
+    void operator() (const batch_type& items) const
+    {
+        _block->fn(items);
+    }
+
+private:
+
+    struct block
+    {
+        block(const Allocator& a, delegate<void(const batch_type&)> f) :
+            alloc(a),
+            fn(std::move(f))
+        {
+        }
+
+        Allocator                           alloc;
+        delegate<void(const batch_type&)>   fn;
+    };
+
+    block* _block;
+};
+
+#endif
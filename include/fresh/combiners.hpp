@@ -0,0 +1,361 @@
+//
+// combiners.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_combiners_hpp
+#define fresh_combiners_hpp
+
+#include "config.hpp"
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Combiners receive the result of each slot of a non-void event, in connection
+// order, and produce the result of the emit. Returning false from operator()
+// stops the event from calling the remaining slots.
+//
+// A combiner can be chosen for every emit of an event with its Combiner
+// template parameter, or for a single emit with event::combine.
+//
+// Combiners which also have split() and merge() can be used when a thread-safe
+// event dispatches in parallel. split() returns an empty combiner for a subset
+// of the slots, and merge() adds the results of one which received the slots
+// following this one's. Returning false then only stops calling the slots in
+// that subset.
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    template <class T, template <class S> class Alloc = std::allocator>
+    class collect
+    {
+    public:
+
+        using result_type = std::vector<T, Alloc<T>>;
+        using allocator_type = Alloc<T>;
+
+        collect(const allocator_type& alloc = allocator_type()) :
+            _results(alloc)
+        {
+        }
+
+        bool operator() (T value)
+        {
+            _results.push_back(std::move(value));
+            return true;
+        }
+
+        result_type result()
+        {
+            return std::move(_results);
+        }
+
+        collect split() const
+        {
+            return collect(_results.get_allocator());
+        }
+
+        void merge(collect&& other)
+        {
+            for (auto& value : other._results)
+            {
+                _results.push_back(std::move(value));
+            }
+        }
+
+    private:
+
+        result_type _results;
+    };
+
+    template <class T>
+    class last_value
+    {
+    public:
+
+        using result_type = T;
+
+        bool operator() (T value)
+        {
+            _value = std::move(value);
+            _received = true;
+            return true;
+        }
+
+        result_type result()
+        {
+            return std::move(_value);
+        }
+
+        last_value split() const
+        {
+            return last_value();
+        }
+
+        void merge(last_value&& other)
+        {
+            if (other._received)
+            {
+                _value = std::move(other._value);
+                _received = true;
+            }
+        }
+
+    private:
+
+        T       _value = T();
+        bool    _received = false;
+    };
+
+    template <class T>
+    class first_non_default
+    {
+    public:
+
+        using result_type = T;
+
+        bool operator() (T value)
+        {
+            if (value == T())
+            {
+                return true;
+            }
+
+            _value = std::move(value);
+            return false;
+        }
+
+        result_type result()
+        {
+            return std::move(_value);
+        }
+
+        first_non_default split() const
+        {
+            return first_non_default();
+        }
+
+        void merge(first_non_default&& other)
+        {
+            if (_value == T())
+            {
+                _value = std::move(other._value);
+            }
+        }
+
+    private:
+
+        T _value = T();
+    };
+
+    template <class T, class Op = std::plus<T>>
+    class reduce
+    {
+    public:
+
+        using result_type = T;
+
+        reduce(T initial = T(), Op op = Op()) :
+            _value(std::move(initial)),
+            _op(std::move(op))
+        {
+        }
+
+        bool operator() (T value)
+        {
+            accumulate(std::move(value));
+            return true;
+        }
+
+        result_type result()
+        {
+            return std::move(_value);
+        }
+
+        // Op must be associative for the result not to depend on how the
+        // slots were split.
+        reduce split() const
+        {
+            reduce partial(T(), _op);
+            partial._empty = true;
+            return partial;
+        }
+
+        void merge(reduce&& other)
+        {
+            if (!other._empty)
+            {
+                accumulate(std::move(other._value));
+            }
+        }
+
+    private:
+
+        void accumulate(T value)
+        {
+            if (_empty)
+            {
+                _value = std::move(value);
+                _empty = false;
+            }
+            else
+            {
+                _value = _op(std::move(_value), std::move(value));
+            }
+        }
+
+        T       _value;
+        Op      _op;
+        bool    _empty = false;
+    };
+
+    template <class T>
+    using sum = reduce<T, std::plus<T>>;
+
+    class any_of
+    {
+    public:
+
+        using result_type = bool;
+
+        template <class T>
+        bool operator() (const T& value)
+        {
+            _value = !!value;
+            return !_value;
+        }
+
+        result_type result() const
+        {
+            return _value;
+        }
+
+        any_of split() const
+        {
+            return any_of();
+        }
+
+        void merge(any_of&& other)
+        {
+            _value = _value || other._value;
+        }
+
+    private:
+
+        bool _value = false;
+    };
+
+    class all_of
+    {
+    public:
+
+        using result_type = bool;
+
+        template <class T>
+        bool operator() (const T& value)
+        {
+            _value = !!value;
+            return _value;
+        }
+
+        result_type result() const
+        {
+            return _value;
+        }
+
+        all_of split() const
+        {
+            return all_of();
+        }
+
+        void merge(all_of&& other)
+        {
+            _value = _value && other._value;
+        }
+
+    private:
+
+        bool _value = true;
+    };
+
+    template <class OutputIt>
+    class output
+    {
+    public:
+
+        using result_type = OutputIt;
+
+        output(OutputIt it) :
+            _it(std::move(it))
+        {
+        }
+
+        template <class T>
+        bool operator() (T&& value)
+        {
+            *_it = std::forward<T>(value);
+            ++_it;
+            return true;
+        }
+
+        result_type result()
+        {
+            return _it;
+        }
+
+    private:
+
+        OutputIt _it;
+    };
+
+    template <class Combiner, class = void>
+    struct is_parallel_combiner : std::false_type
+    {
+    };
+
+    template <class Combiner>
+    struct is_parallel_combiner<Combiner,
+        std::void_t<decltype(std::declval<Combiner&>().merge(
+            std::declval<const Combiner&>().split()))>> : std::true_type
+    {
+    };
+
+    template <class FnType, template <class S> class Alloc>
+    struct default_combiner;
+
+    template <class Result, class... Args, template <class S> class Alloc>
+    struct default_combiner<Result(Args...), Alloc>
+    {
+        using type = collect<Result, Alloc>;
+    };
+
+    template <class... Args, template <class S> class Alloc>
+    struct default_combiner<void(Args...), Alloc>
+    {
+        using type = void;
+    };
+
+    // What emitting with Combiner returns; void events have no combiner.
+    template <class Combiner>
+    struct combined_result
+    {
+        using type = typename Combiner::result_type;
+    };
+
+    template <>
+    struct combined_result<void>
+    {
+        using type = void;
+    };
+
+    FRESH_END_NAMESPACE
+}
+
+#endif
@@ -0,0 +1,38 @@
+//
+// config.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_config_hpp
+#define fresh_config_hpp
+
+// Define FRESH_EVENT_INSTRUMENTATION to 1, before including any fresh header,
+// to have every event count its emits, connections and disconnections, time
+// each slot call and list itself in the event_registry. When it's 0, the
+// default, none of this is compiled in.
+//
+// Translation units may differ in whether they define it. When it's 1, all of
+// fresh is declared in an inline namespace of its own, so an instrumented
+// event is a different type from an uninstrumented one, and the two share
+// nothing, not even the epoch domain or the shared thread pool.
+#ifndef FRESH_EVENT_INSTRUMENTATION
+
+    #define FRESH_EVENT_INSTRUMENTATION 0
+
+#endif
+
+#if FRESH_EVENT_INSTRUMENTATION
+
+    #define FRESH_BEGIN_NAMESPACE inline namespace instrumented {
+    #define FRESH_END_NAMESPACE }
+
+#else
+
+    #define FRESH_BEGIN_NAMESPACE
+    #define FRESH_END_NAMESPACE
+
+#endif
+
+#endif
@@ -8,101 +8,244 @@
 #ifndef fresh_connection_hpp
 #define fresh_connection_hpp
 
-#include "event_details/connection_base.hpp"
-#include "event_details/source_base.hpp"
-#include "event_details/traits.hpp"
+#include "config.hpp"
+#include "event_details/event_core.hpp"
 #include "event_details/event_interface.hpp"
-#include "threads.hpp"
+#include "event_details/slot_table.hpp"
 
-#include <cassert>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+
     template <bool ThreadSafe = false>
     class connection;
-    
-    template <class Impl, class FnType, bool ThreadSafe, template <class T> class Alloc>
-    class event_base;
+
+    template <bool ThreadSafe = false>
+    class connection_group;
+
+    FRESH_END_NAMESPACE
 }
 
+// Disconnects a slot from its event when destroyed. A connection is two
+// words: the index and generation of its event's core, and the slot's handle.
+// It has no pointer to its event and the event has none to it, so moving one
+// is a copy, and it can safely outlive its event.
 template <bool ThreadSafe>
-class fresh::connection :
-    public event_details::connection_base<connection<ThreadSafe>>
+class fresh::connection
 {
 public:
-    
-    using mutex_type =
-        typename event_details::event_traits<ThreadSafe>::connection_mutex_type;
-    using lock_type = std::lock_guard<mutex_type>;
+
+    // A connection to nothing, e.g. from connecting to a full static_event.
+    connection()
+    {
+    }
 
     connection (const connection& other) = delete;
 
-    connection(connection&& other)
+    connection(connection&& other) :
+    _core(other._core),
+    _generation(other._generation),
+    _handle(other._handle)
+    {
+        other._core = npos;
+    }
+
+    ~connection()
+    {
+        disconnect();
+    }
+
+    connection& operator= (const connection& other) = delete;
+
+    connection& operator= (connection&& other)
     {
-        lock_type lock1(_mutex);
-        lock_type lock2(other._mutex);
-        
-        _event = other._event;
-        _fn = other._fn;
-        _source = other._source;
-        
-        if (_source)
+        if (this != &other)
         {
-            assert(_source->_connection == &other);
-            _source->_connection = this;
+            disconnect();
+
+            _core = other._core;
+            _generation = other._generation;
+            _handle = other._handle;
+
+            other._core = npos;
         }
-        
-        other._event = nullptr;
-        other._fn = nullptr;
-        other._source = nullptr;
+
+        return *this;
     }
-    
-    ~connection()
+
+    // Whether the connection was made and its event still exists.
+    bool connected() const
+    {
+        return _core != npos &&
+            event_details::event_core_table::instance().at(_core).generation() ==
+                _generation;
+    }
+
+    void disconnect()
     {
-        if (!!_event)
+        if (_core == npos)
         {
-            _event->close(*this);
+            return;
         }
+
+        auto& core = event_details::event_core_table::instance().at(_core);
+
+        if (event_details::event_core::entry entry {core, _generation})
+        {
+            static_cast<event_details::event_interface<ThreadSafe>*>(core.event())
+                ->close(_handle);
+        }
+
+        _core = npos;
     }
-    
-    connection& operator= (const connection& other) = delete;
 
     bool operator< (const connection& rhs) const
     {
-        lock_type lock1(_mutex);
-        lock_type lock2(rhs._mutex);
-        
-        return _fn < rhs._fn;
+        return std::tie(_core, _generation, _handle) <
+            std::tie(rhs._core, rhs._generation, rhs._handle);
     }
-    
+
 private:
-    template <class Impl, class FnType, bool ThreadSafeBase, template <class T> class Alloc>
-    friend class fresh::event_base;
-    
-    friend class event_details::connection_base<connection<ThreadSafe>>;
-    
-    template<class Fn>
-    connection(void* fn, event_details::event_interface<ThreadSafe>* e,
-               event_details::source<Fn, ThreadSafe>* src) :
-    _event(e),
-    _fn(fn),
-    _source(src)
-    {
-        src->_connection = this;
-    }
-    
-    void clear()
-    {
-        lock_type lock(_mutex);
-        
-        _event = nullptr;
-        _fn = nullptr;
-    }
-    
-    event_details::event_interface<ThreadSafe>* _event;
-    void*                                       _fn;
-    event_details::source_base<ThreadSafe>*     _source;
-    mutable mutex_type                          _mutex;
+
+    friend event_details::event_interface<ThreadSafe>;
+    friend connection_group<ThreadSafe>;
+
+    using handle_type = event_details::slot_handle;
+
+    static const uint32_t npos = event_details::event_core_table::npos;
+
+    connection(uint32_t core, uint32_t generation, const handle_type& handle) :
+    _core(core),
+    _generation(generation),
+    _handle(handle)
+    {
+    }
+
+    uint32_t        _core = npos;
+    uint32_t        _generation = 0;
+    handle_type     _handle;
+};
+
+// Connections which are disconnected together, e.g. those of an object with
+// many observers. Disconnecting the group closes all of its slots on each
+// event at once, so a thread-safe event takes its mutex and republishes its
+// slots once per group rather than once per slot.
+template <bool ThreadSafe>
+class fresh::connection_group
+{
+public:
+
+    connection_group()
+    {
+    }
+
+    connection_group(const connection_group& other) = delete;
+
+    connection_group(connection_group&& other) :
+    _connections(std::move(other._connections))
+    {
+    }
+
+    ~connection_group()
+    {
+        disconnect_all();
+    }
+
+    connection_group& operator= (const connection_group& other) = delete;
+
+    connection_group& operator= (connection_group&& other)
+    {
+        if (this != &other)
+        {
+            disconnect_all();
+            _connections = std::move(other._connections);
+        }
+
+        return *this;
+    }
+
+    void add(connection<ThreadSafe> cnxn)
+    {
+        _connections.push_back(std::move(cnxn));
+    }
+
+    void reserve(size_t count)
+    {
+        _connections.reserve(count);
+    }
+
+    size_t size() const
+    {
+        return _connections.size();
+    }
+
+    bool empty() const
+    {
+        return _connections.empty();
+    }
+
+    void disconnect_all()
+    {
+        // Closing a slot can destroy what it captured, which might use the
+        // group, so it's emptied first.
+        std::vector<connection<ThreadSafe>> connections;
+        connections.swap(_connections);
+
+        // Connections to the same event end up next to each other.
+        std::sort(connections.begin(), connections.end());
+
+        std::vector<event_details::slot_handle> handles;
+
+        for (auto first = connections.begin(); first != connections.end();)
+        {
+            auto last = first;
+
+            while (last != connections.end() && last->_core == first->_core &&
+                   last->_generation == first->_generation)
+            {
+                ++last;
+            }
+
+            uint32_t core = first->_core;
+
+            if (core != connection<ThreadSafe>::npos)
+            {
+                handles.clear();
+
+                for (auto cnxn = first; cnxn != last; ++cnxn)
+                {
+                    handles.push_back(cnxn->_handle);
+                    cnxn->_core = connection<ThreadSafe>::npos;
+                }
+
+                close(core, first->_generation, handles);
+            }
+
+            first = last;
+        }
+    }
+
+private:
+
+    static void close(uint32_t index, uint32_t generation,
+                      const std::vector<event_details::slot_handle>& handles)
+    {
+        auto& core = event_details::event_core_table::instance().at(index);
+
+        if (event_details::event_core::entry entry {core, generation})
+        {
+            static_cast<event_details::event_interface<ThreadSafe>*>(core.event())
+                ->close_many(handles.data(), handles.size());
+        }
+    }
+
+    std::vector<connection<ThreadSafe>> _connections;
 };
 
 #endif
@@ -0,0 +1,346 @@
+//
+// delegate.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_delegate_hpp
+#define fresh_delegate_hpp
+
+#include "config.hpp"
+#include "event_details/allocation.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    template <class FnType>
+    class delegate;
+
+    FRESH_END_NAMESPACE
+}
+
+// A move-only replacement for std::function. Callables which fit in
+// inline_size bytes and can be moved without throwing, including lambdas
+// capturing a few pointers and bound member functions, are stored inline and
+// never allocate. Larger ones are allocated with the given allocator, or with
+// new if there isn't one.
+template <class Result, class... Args>
+class fresh::delegate<Result(Args...)>
+{
+public:
+
+    static const size_t inline_size = 4 * sizeof(void*);
+
+    delegate()
+    {
+    }
+
+    delegate(std::nullptr_t)
+    {
+    }
+
+    template <class Fn,
+        class = typename std::enable_if<
+            !std::is_same<typename std::decay<Fn>::type, delegate>::value &&
+            std::is_invocable_r<Result, typename std::decay<Fn>::type&, Args...>::value>::type>
+    delegate(Fn&& fn)
+    {
+        if (!is_empty(fn))
+        {
+            using target_type = typename std::decay<Fn>::type;
+
+            init<target_type>(std::forward<Fn>(fn),
+                std::integral_constant<bool, fits_inline<target_type>::value>());
+        }
+    }
+
+    template <class Allocator, class Fn,
+        class = typename std::enable_if<
+            !std::is_same<typename std::decay<Fn>::type, delegate>::value &&
+            std::is_invocable_r<Result, typename std::decay<Fn>::type&, Args...>::value>::type>
+    delegate(std::allocator_arg_t, const Allocator& alloc, Fn&& fn)
+    {
+        if (!is_empty(fn))
+        {
+            using target_type = typename std::decay<Fn>::type;
+
+            init<target_type>(alloc, std::forward<Fn>(fn),
+                std::integral_constant<bool, fits_inline<target_type>::value>());
+        }
+    }
+
+    delegate(const delegate& other) = delete;
+
+    delegate(delegate&& other) :
+        _invoke(other._invoke),
+        _manage(other._manage)
+    {
+        move_storage(other);
+    }
+
+    ~delegate()
+    {
+        reset();
+    }
+
+    delegate& operator= (const delegate& other) = delete;
+
+    delegate& operator= (delegate&& other)
+    {
+        if (this != &other)
+        {
+            reset();
+
+            _invoke = other._invoke;
+            _manage = other._manage;
+            move_storage(other);
+        }
+
+        return *this;
+    }
+
+    delegate& operator= (std::nullptr_t)
+    {
+        reset();
+        return *this;
+    }
+
+    explicit operator bool() const
+    {
+        return _invoke != nullptr;
+    }
+
+    Result operator() (Args... args) const
+    {
+        return _invoke(&_storage, std::forward<Args>(args)...);
+    }
+
+    // The callable, if it's an Fn held inline or allocated with new, or null
+    // otherwise.
+    template <class Fn>
+    const Fn* target() const
+    {
+        if (_invoke == &invoke_inline<Fn>)
+        {
+            return static_cast<const Fn*>(static_cast<const void*>(&_storage));
+        }
+
+        if (_invoke == &invoke_heap<Fn>)
+        {
+            return *static_cast<Fn* const*>(static_cast<const void*>(&_storage));
+        }
+
+        return nullptr;
+    }
+
+    // Binds a member function to an object, e.g. delegate::bind<&A::f>(a).
+    // The delegate doesn't own the object.
+    template <auto Method, class Owner>
+    static delegate bind(Owner& owner)
+    {
+        delegate result;
+
+        new (&result._storage) Owner*(&owner);
+        result._invoke = &invoke_method<Method, Owner>;
+
+        return result;
+    }
+
+private:
+
+    using storage_type =
+        typename std::aligned_storage<inline_size, alignof(std::max_align_t)>::type;
+    using invoke_type = Result (*)(void* storage, Args&&... args);
+    using manage_type = void (*)(void* dst, void* src);
+
+    template <class Fn>
+    struct fits_inline
+    {
+        static const bool value =
+            sizeof(Fn) <= sizeof(storage_type) &&
+            alignof(Fn) <= alignof(storage_type) &&
+            std::is_nothrow_move_constructible<Fn>::value;
+    };
+
+    template <class Fn>
+    static bool is_empty(const Fn&)
+    {
+        return false;
+    }
+
+    template <class R, class... A>
+    static bool is_empty(R (*fn)(A...))
+    {
+        return fn == nullptr;
+    }
+
+    template <class F>
+    static bool is_empty(const std::function<F>& fn)
+    {
+        return !fn;
+    }
+
+    template <class Target, class Fn>
+    void init(Fn&& fn, std::true_type)
+    {
+        new (&_storage) Target(std::forward<Fn>(fn));
+        _invoke = &invoke_inline<Target>;
+
+        if (!std::is_trivially_copyable<Target>::value)
+        {
+            _manage = &manage_inline<Target>;
+        }
+    }
+
+    template <class Target, class Fn>
+    void init(Fn&& fn, std::false_type)
+    {
+        new (&_storage) Target*(new Target(std::forward<Fn>(fn)));
+        _invoke = &invoke_heap<Target>;
+        _manage = &manage_heap<Target>;
+    }
+
+    template <class Target, class Allocator, class Fn>
+    void init(const Allocator&, Fn&& fn, std::true_type)
+    {
+        init<Target>(std::forward<Fn>(fn), std::true_type());
+    }
+
+    // The allocator is kept with the callable, so it can free it.
+    template <class Target, class Allocator, class Fn>
+    void init(const Allocator& alloc, Fn&& fn, std::false_type)
+    {
+        new (&_storage) allocated<Target, Allocator>*(
+            event_details::allocate_object<allocated<Target, Allocator>>(
+                alloc, alloc, std::forward<Fn>(fn)));
+
+        _invoke = &invoke_allocated<Target, Allocator>;
+        _manage = &manage_allocated<Target, Allocator>;
+    }
+
+    template <class Target, class Allocator>
+    struct allocated
+    {
+        template <class Fn>
+        allocated(const Allocator& a, Fn&& fn) :
+            alloc(a),
+            target(std::forward<Fn>(fn))
+        {
+        }
+
+        Allocator   alloc;
+        Target      target;
+    };
+
+    template <class Fn>
+    static Result invoke_inline(void* storage, Args&&... args)
+    {
+        return static_cast<Result>(
+            (*static_cast<Fn*>(storage))(std::forward<Args>(args)...));
+    }
+
+    template <class Fn>
+    static Result invoke_heap(void* storage, Args&&... args)
+    {
+        return static_cast<Result>(
+            (**static_cast<Fn**>(storage))(std::forward<Args>(args)...));
+    }
+
+    template <class Fn, class Allocator>
+    static Result invoke_allocated(void* storage, Args&&... args)
+    {
+        return static_cast<Result>(
+            ((*static_cast<allocated<Fn, Allocator>**>(storage))->target)(
+                std::forward<Args>(args)...));
+    }
+
+    template <auto Method, class Owner>
+    static Result invoke_method(void* storage, Args&&... args)
+    {
+        return static_cast<Result>(
+            ((*static_cast<Owner**>(storage))->*Method)(std::forward<Args>(args)...));
+    }
+
+    // Moves the callable from src to dst, or destroys src if dst is null.
+    template <class Fn>
+    static void manage_inline(void* dst, void* src)
+    {
+        if (dst)
+        {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+        }
+
+        static_cast<Fn*>(src)->~Fn();
+    }
+
+    template <class Fn>
+    static void manage_heap(void* dst, void* src)
+    {
+        if (dst)
+        {
+            std::memcpy(dst, src, sizeof(Fn*));
+        }
+        else
+        {
+            delete *static_cast<Fn**>(src);
+        }
+    }
+
+    template <class Fn, class Allocator>
+    static void manage_allocated(void* dst, void* src)
+    {
+        using block_type = allocated<Fn, Allocator>;
+
+        if (dst)
+        {
+            std::memcpy(dst, src, sizeof(block_type*));
+        }
+        else
+        {
+            auto block = *static_cast<block_type**>(src);
+            event_details::destroy_object(block->alloc, block);
+        }
+    }
+
+    void move_storage(delegate& other)
+    {
+        if (_manage)
+        {
+            _manage(&_storage, &other._storage);
+        }
+        else if (_invoke)
+        {
+            std::memcpy(&_storage, &other._storage, sizeof(storage_type));
+        }
+
+        other._invoke = nullptr;
+        other._manage = nullptr;
+    }
+
+    void reset()
+    {
+        if (_manage)
+        {
+            _manage(nullptr, &_storage);
+        }
+
+        _invoke = nullptr;
+        _manage = nullptr;
+    }
+
+    mutable storage_type    _storage;
+    invoke_type             _invoke = nullptr;
+    manage_type             _manage = nullptr;
+};
+
+#endif
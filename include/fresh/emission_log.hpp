@@ -0,0 +1,557 @@
+//
+// emission_log.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_emission_log_hpp
+#define fresh_emission_log_hpp
+
+// Records emissions to a memory-mapped file, and replays them later, e.g. to
+// reproduce a burst of notifications offline. Only available where there's
+// mmap.
+#if defined(__unix__) || defined(__APPLE__)
+
+#include "config.hpp"
+#include "connection.hpp"
+#include "delegate.hpp"
+#include "event_details/packed_args.hpp"
+#include "event_details/traits.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    class emission_log;
+
+    template <class FnType, bool ThreadSafe = true>
+    class emission_recorder;
+
+    class emission_replayer;
+
+    enum class replay_speed
+    {
+        // Waits between emissions as long as there was between the recorded
+        // ones.
+        original,
+
+        // Emits one after another, as fast as possible.
+        maximum
+    };
+
+    namespace event_details
+    {
+        template <class FnType>
+        struct replay_target;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// A compact binary log of emissions in a file: for each one, when it happened,
+// the id of the event, and its arguments' bytes.
+//
+// The file is divided into chunks, and each recording thread writes to a chunk
+// of its own, claiming a new one when it's full with a single atomic add, so
+// appending neither locks nor allocates, nor contends with other threads. Once
+// every chunk has been claimed, further emissions are dropped and counted.
+class fresh::emission_log
+{
+public:
+
+    static const size_t default_chunk_size = 64 * 1024;
+
+    struct entry
+    {
+        // Nanoseconds since the log was created, not counting the time it
+        // spent closed, since each process has a clock of its own.
+        uint64_t                time;
+        uint32_t                id;
+        uint32_t                size;
+        const unsigned char*    data;
+    };
+
+    // Creates a log at path of up to about capacity bytes, replacing any file
+    // that's there.
+    static emission_log create(const std::string& path, size_t capacity,
+                               size_t chunk_size = default_chunk_size)
+    {
+        if (chunk_size < chunk_header_size + sizeof(record) || chunk_size % alignment != 0)
+        {
+            throw std::invalid_argument("emission_log chunk size is too small or unaligned");
+        }
+
+        int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+
+        if (fd < 0)
+        {
+            throw_errno("open");
+        }
+
+        return emission_log(fd, std::max<size_t>(capacity / chunk_size, 1), chunk_size);
+    }
+
+    // Opens an existing log, to replay it or to record more to it.
+    static emission_log open(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDWR);
+
+        if (fd < 0)
+        {
+            throw_errno("open");
+        }
+
+        return emission_log(fd);
+    }
+
+    emission_log(const emission_log& other) = delete;
+
+    emission_log(emission_log&& other) :
+        _fd(other._fd),
+        _size(other._size),
+        _header(other._header),
+        _serial(other._serial),
+        _time_base(other._time_base)
+    {
+        other._fd = -1;
+        other._header = nullptr;
+    }
+
+    ~emission_log()
+    {
+        if (_header)
+        {
+            ::munmap(_header, _size);
+        }
+
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+        }
+    }
+
+    emission_log& operator= (const emission_log& other) = delete;
+
+    // Appends an emission of event id with size bytes of arguments. Returns
+    // false if it was dropped because the log is full.
+    bool append(uint32_t id, const void* data, uint32_t size)
+    {
+        size_t needed = sizeof(record) + aligned(size);
+        auto& w = local_writer();
+
+        if (!w.chunk || w.used + needed > _header->chunk_size)
+        {
+            if (needed > _header->chunk_size - chunk_header_size || !claim(w))
+            {
+                _header->dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        record r;
+        r.time = (uint64_t)(now() - _time_base);
+        r.id = id;
+        r.size = size;
+
+        std::memcpy(w.chunk + w.used, &r, sizeof(r));
+        std::memcpy(w.chunk + w.used + sizeof(r), data, size);
+
+        w.used += (uint32_t)needed;
+        used(w.chunk).store(w.used, std::memory_order_release);
+
+        return true;
+    }
+
+    // How many emissions were dropped because the log was full.
+    uint64_t dropped() const
+    {
+        return _header->dropped.load(std::memory_order_relaxed);
+    }
+
+    // Every emission recorded so far, in the order they happened. The entries
+    // point into the log, so they're only valid while it's open.
+    std::vector<entry> entries() const
+    {
+        std::vector<entry> result;
+
+        for_each_entry([&](const entry& e) { result.push_back(e); });
+
+        // Each chunk is already in order, since only one thread wrote to it.
+        std::stable_sort(result.begin(), result.end(),
+            [](const entry& a, const entry& b) { return a.time < b.time; });
+
+        return result;
+    }
+
+private:
+
+    static const uint64_t magic = 0x676f6c6873657266;
+    static const size_t alignment = 8;
+    static const size_t chunk_header_size = alignment;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+                  "Mapped atomics must be lock-free.");
+
+    struct header
+    {
+        uint64_t                    magic;
+        uint64_t                    capacity;
+        uint64_t                    chunk_size;
+
+        // When the log was created, on the creating process's clock.
+        int64_t                     start;
+        alignas(64) std::atomic<uint64_t> chunks;
+        alignas(64) std::atomic<uint64_t> dropped;
+    };
+
+    struct record
+    {
+        uint64_t    time;
+        uint32_t    id;
+        uint32_t    size;
+    };
+
+    // How many logs a thread can append to in turn without claiming a new
+    // chunk each time it switches.
+    static const size_t writers_per_thread = 8;
+
+    // The chunk a thread is appending to. log is the serial number of the log
+    // it belongs to, so a new log at the same address doesn't find it, and
+    // last is when the thread last appended with it.
+    struct writer
+    {
+        uint64_t        log = 0;
+        unsigned char*  chunk = nullptr;
+        uint32_t        used = 0;
+        uint64_t        last = 0;
+    };
+
+    static size_t header_size()
+    {
+        return (sizeof(header) + 63) / 64 * 64;
+    }
+
+    static size_t aligned(size_t size)
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // The calling thread's writer for this log. If it has none, the one it
+    // used least recently is given up, and its chunk left as it is.
+    writer& local_writer() const
+    {
+        thread_local writer writers[writers_per_thread];
+        thread_local uint64_t clock = 0;
+
+        writer* oldest = &writers[0];
+
+        for (auto& w : writers)
+        {
+            if (w.log == _serial)
+            {
+                w.last = ++clock;
+                return w;
+            }
+
+            if (w.last < oldest->last)
+            {
+                oldest = &w;
+            }
+        }
+
+        *oldest = writer();
+        oldest->log = _serial;
+        oldest->last = ++clock;
+
+        return *oldest;
+    }
+
+    static uint64_t next_serial()
+    {
+        static std::atomic<uint64_t> serial {0};
+        return serial.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // The number of bytes of a chunk written so far, header included.
+    static std::atomic<uint32_t>& used(unsigned char* chunk)
+    {
+        return *reinterpret_cast<std::atomic<uint32_t>*>(chunk);
+    }
+
+    // Creates a new log in the empty file fd.
+    emission_log(int fd, size_t capacity, size_t chunk_size) :
+        _fd(fd),
+        _size(header_size() + capacity * chunk_size),
+        _serial(next_serial())
+    {
+        // The file is sparse, so chunks only take up space once written to.
+        if (::ftruncate(fd, (off_t)_size) != 0)
+        {
+            ::close(fd);
+            throw_errno("ftruncate");
+        }
+
+        map();
+
+        _header->capacity = capacity;
+        _header->chunk_size = chunk_size;
+        _header->start = now();
+        _header->magic = magic;
+
+        _time_base = _header->start;
+    }
+
+    // Maps an existing log.
+    emission_log(int fd) :
+        _fd(fd),
+        _serial(next_serial())
+    {
+        struct stat st;
+
+        if (::fstat(fd, &st) != 0 || (size_t)st.st_size < header_size())
+        {
+            ::close(fd);
+            throw std::runtime_error("not an emission_log");
+        }
+
+        _size = (size_t)st.st_size;
+
+        map();
+
+        if (_header->magic != magic ||
+            _size != header_size() + _header->capacity * _header->chunk_size)
+        {
+            ::munmap(_header, _size);
+            ::close(fd);
+            throw std::runtime_error("not an emission_log");
+        }
+
+        // The log may have been recorded by another process, so times carry
+        // on from the latest one recorded rather than from its start.
+        int64_t latest = -1;
+
+        for_each_entry([&](const entry& e) { latest = std::max(latest, (int64_t)e.time); });
+
+        _time_base = now() - (latest + 1);
+    }
+
+    void map()
+    {
+        void* p = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+
+        if (p == MAP_FAILED)
+        {
+            ::close(_fd);
+            throw_errno("mmap");
+        }
+
+        _header = static_cast<header*>(p);
+    }
+
+    // Calls fn on every emission recorded so far, chunk by chunk.
+    template <class Fn>
+    void for_each_entry(Fn fn) const
+    {
+        size_t chunks = (size_t)std::min(_header->chunks.load(std::memory_order_acquire),
+                                         _header->capacity);
+
+        for (size_t i = 0; i < chunks; i++)
+        {
+            unsigned char* chunk = chunk_at(i);
+            uint32_t end = used(chunk).load(std::memory_order_acquire);
+
+            for (uint32_t offset = chunk_header_size; offset < end; )
+            {
+                record r;
+                std::memcpy(&r, chunk + offset, sizeof(r));
+
+                fn(entry { r.time, r.id, r.size, chunk + offset + sizeof(r) });
+
+                offset += (uint32_t)(sizeof(r) + aligned(r.size));
+            }
+        }
+    }
+
+    bool claim(writer& w)
+    {
+        uint64_t index = _header->chunks.fetch_add(1, std::memory_order_relaxed);
+
+        if (index >= _header->capacity)
+        {
+            w.chunk = nullptr;
+            return false;
+        }
+
+        w.chunk = chunk_at((size_t)index);
+        w.used = chunk_header_size;
+
+        return true;
+    }
+
+    unsigned char* chunk_at(size_t index) const
+    {
+        return reinterpret_cast<unsigned char*>(_header) + header_size() +
+            index * _header->chunk_size;
+    }
+
+    [[noreturn]] static void throw_errno(const char* what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    int         _fd = -1;
+    size_t      _size = 0;
+    header*     _header = nullptr;
+    uint64_t    _serial;
+
+    // What append subtracts from now() to get an entry's time.
+    int64_t     _time_base = 0;
+};
+
+// Appends every emission of an event to a log, under the given id, for as
+// long as it exists. Arguments must be trivially copyable once decayed.
+template <bool ThreadSafe, class... Args>
+class fresh::emission_recorder<void(Args...), ThreadSafe>
+{
+public:
+
+    using record_type = event_details::packed_args<typename std::decay<Args>::type...>;
+
+    template <class Event>
+    emission_recorder(Event& e, emission_log& log, uint32_t id) :
+        _log(log),
+        _id(id)
+    {
+        _connection = e.connect(
+            [this](event_details::param_type<Args>... args)
+            {
+                unsigned char data[record_type::size + 1];
+
+                record_type::pack(data, args...);
+                _log.append(_id, data, (uint32_t)record_type::size);
+            });
+    }
+
+    emission_recorder(const emission_recorder& other) = delete;
+
+    emission_recorder& operator= (const emission_recorder& other) = delete;
+
+private:
+
+    emission_log&               _log;
+    uint32_t                    _id;
+    connection<ThreadSafe>      _connection;
+};
+
+// Unpacks a recorded emission and emits it again.
+template <class... Args>
+struct fresh::event_details::replay_target<void(Args...)>
+{
+    using record_type = packed_args<typename std::decay<Args>::type...>;
+
+    template <class Event>
+    static delegate<void(const unsigned char*)> make(Event& e)
+    {
+        return [&e](const unsigned char* data) { record_type::unpack(data, e); };
+    }
+};
+
+// Emits a log's emissions again, in the order they were recorded, each on the
+// event added with its id. Emissions of ids which haven't been added are
+// skipped.
+class fresh::emission_replayer
+{
+public:
+
+    emission_replayer(const emission_log& log) :
+        _log(log)
+    {
+    }
+
+    emission_replayer(const emission_replayer& other) = delete;
+
+    emission_replayer& operator= (const emission_replayer& other) = delete;
+
+    // Replays emissions recorded with id on e, which must have the same
+    // signature as the recorded event.
+    template <class Event>
+    void add(uint32_t id, Event& e)
+    {
+        using target = event_details::replay_target<typename Event::function_type>;
+
+        _targets[id] = { target::record_type::size, target::make(e) };
+    }
+
+    // Replays the whole log on the calling thread, and returns the number of
+    // emissions replayed.
+    size_t replay(replay_speed speed = replay_speed::maximum)
+    {
+        auto entries = _log.entries();
+        auto start = std::chrono::steady_clock::now();
+        size_t replayed = 0;
+
+        for (auto& e : entries)
+        {
+            auto found = _targets.find(e.id);
+
+            if (found == _targets.end() || found->second.size != e.size)
+            {
+                continue;
+            }
+
+            if (speed == replay_speed::original)
+            {
+                std::this_thread::sleep_until(start +
+                    std::chrono::nanoseconds(e.time - entries.front().time));
+            }
+
+            found->second.emit(e.data);
+            ++replayed;
+        }
+
+        return replayed;
+    }
+
+private:
+
+    struct target
+    {
+        size_t                                  size;
+        delegate<void(const unsigned char*)>    emit;
+    };
+
+    const emission_log&                         _log;
+    std::unordered_map<uint32_t, target>        _targets;
+};
+
+#endif
+
+#endif
@@ -8,27 +8,47 @@
 #ifndef fresh_event_hpp
 #define fresh_event_hpp
 
+#include "config.hpp"
+#include "batch.hpp"
+#include "combiners.hpp"
 #include "connection.hpp"
+#include "delegate.hpp"
+#include "event_details/instrumentation_hooks.hpp"
+#include "event_details/slot_table.hpp"
+#include "event_details/snapshot.hpp"
 #include "event_details/source.hpp"
 #include "event_details/traits.hpp"
 #include "threads.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <functional>
-#include <map>
 #include <memory>
-#include <set>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+    
+    // Only needed by those who use them, so they aren't included here.
+    class thread_context;
+    
+    class work_stealing_pool;
+    
     template <class FnType, bool ThreadSafe = false,
-        template <class T> class Alloc = std::allocator>
+        template <class T> class Alloc = std::allocator,
+        class Combiner = typename default_combiner<FnType, Alloc>::type,
+        class Locking = default_locking>
     class event;
     
     template <class Impl,
         class FnType,
         bool ThreadSafe,
-        template <class T> class Alloc>
+        template <class T> class Alloc,
+        class Locking>
     class event_base;
     
     template <class Impl,
@@ -38,6 +58,7 @@ namespace fresh
         template <class T> class Alloc>
     class event_caller;
 
+    FRESH_END_NAMESPACE
 }
 
 template <class Impl,
@@ -49,22 +70,47 @@ class fresh::event_caller<Impl, ImplBase, ReturnType(Args...), false, Alloc> :
     public event_details::event_interface<false>
 {
     friend Impl;
+    friend ImplBase;
     
     template<class CallHandler>
     void
-    call(CallHandler forEach, Args... args)
+    call(CallHandler&& forEach, event_details::param_type<Args>... args)
     {
-        auto old_can_clean = ((ImplBase*)this)->_can_clean;
-        ((ImplBase*)this)->_can_clean = false;
+        ((ImplBase*)this)->on_emit();
         
-        for (auto& cnxn_source : ((Impl*)this)->_sources)
-        {
-            ((Impl*)this)->call_function(forEach, *cnxn_source.second._fn, args...);
-        }
+        auto& sources = ((ImplBase*)this)->_sources;
+        
+        typename ImplBase::source_table_type::pin pin(sources);
+        
+        sources.for_each(
+            [&](const typename ImplBase::source_type& source)
+            {
+                return ((Impl*)this)->call_function(forEach, source.function(), args...);
+            });
+    }
+    
+    template <class Batch>
+    void call_batch(const Batch& items)
+    {
+        ((ImplBase*)this)->on_emit(items.size());
+        
+        auto& sources = ((ImplBase*)this)->_sources;
         
-        ((ImplBase*)this)->_can_clean = old_can_clean;
+        typename ImplBase::source_table_type::pin pin(sources);
         
-        ((ImplBase*)this)->clean();
+        sources.for_each_checked(
+            [&](const typename ImplBase::source_type& source, const auto& erased)
+            {
+                source.function().template call_batch<typename ImplBase::allocator_type>(
+                    items, erased);
+                
+                return true;
+            });
+    }
+    
+    event_details::retired* publish()
+    {
+        return nullptr;
     }
 };
 
@@ -76,135 +122,638 @@ template <class Impl,
 class fresh::event_caller<Impl, ImplBase, ReturnType(Args...), true, Alloc> :
     public event_details::event_interface<true>
 {
+public:
+    
+    static const size_t default_parallel_threshold = 256;
+    
+    // Once connected to at least threshold slots, emits split the slots across
+    // pool and wait for them all to be called. Results are combined in
+    // parallel if the combiner supports it (see is_parallel_combiner), or the
+    // slots are called on the emitting thread otherwise. If a slot throws, the
+    // rest of its share isn't called, but every other share is, and the first
+    // exception is rethrown once they've all finished.
+    //
+    // The pool is only used through what's instantiated here, so only the
+    // callers of this need to include work_stealing_pool.hpp.
+    template <class Pool,
+        class = typename std::enable_if<std::is_same<Pool, work_stealing_pool>::value>::type>
+    void set_parallel_dispatch(Pool* pool, size_t threshold = default_parallel_threshold)
+    {
+        if (pool)
+        {
+            _parallel_workers.store(pool->size(), std::memory_order_relaxed);
+            _parallel_for.store(&parallel_for<Pool>, std::memory_order_relaxed);
+            _parallel_reduce.store(&parallel_reduce<Pool>, std::memory_order_relaxed);
+        }
+        
+        _parallel_threshold.store(threshold, std::memory_order_relaxed);
+        _pool.store(pool, std::memory_order_release);
+    }
+    
+    // Turns parallel dispatch back off.
+    void set_parallel_dispatch(std::nullptr_t)
+    {
+        _pool.store(nullptr, std::memory_order_release);
+    }
+    
+private:
+    
     friend Impl;
+    friend ImplBase;
     
-    using mutex_type =
-        typename event_details::event_traits<true>::event_mutex_type;
-    using lock_type = std::lock_guard<mutex_type>;
-    using source_type = event_details::source<ReturnType(Args...), true>;
-    using function_type = decltype(source_type::_fn);
+    using snapshot_type = event_details::snapshot<ReturnType(Args...), Alloc>;
+    using publisher_type = event_details::publisher<snapshot_type>;
     
     template<class CallHandler>
     void
-    call(CallHandler forEach, Args... args)
+    call(CallHandler&& forEach, event_details::param_type<Args>... args)
     {
-        std::vector<function_type, Alloc<function_type>> fns;
+        ((ImplBase*)this)->on_emit();
+        
+        typename publisher_type::reader fns(_snapshot);
+        
+        if (!fns)
+        {
+            return;
+        }
         
+        if constexpr (can_call_parallel<typename std::decay<CallHandler>::type>::value)
         {
-            lock_type lock(((ImplBase*)this)->_mutex);
+            auto pool = _pool.load(std::memory_order_acquire);
             
-            for (auto& key_source : ((ImplBase*)this)->_sources)
+            if (pool && (*fns).size() >= _parallel_threshold.load(std::memory_order_relaxed))
             {
-                auto& source = key_source.second;
-                
-                fns.push_back(source._fn);
+                call_parallel(*pool, forEach, *fns, args...);
+                return;
+            }
+        }
+        
+        for (auto& fn : *fns)
+        {
+            if (!((Impl*)this)->call_function(forEach, *fn, args...))
+            {
+                break;
             }
         }
+    }
+    
+    template <class Batch>
+    void call_batch(const Batch& items)
+    {
+        ((ImplBase*)this)->on_emit(items.size());
+        
+        typename publisher_type::reader fns(_snapshot);
+        
+        if (!fns)
+        {
+            return;
+        }
+        
+        for (auto& fn : *fns)
+        {
+            fn->template call_batch<typename ImplBase::allocator_type>(
+                items, []() { return false; });
+        }
+    }
+    
+    template <class CallHandler>
+    struct can_call_parallel
+    {
+        static const bool value = std::is_same<CallHandler, std::nullptr_t>::value ||
+            is_parallel_combiner<CallHandler>::value;
+    };
+    
+    template <class CallHandler>
+    struct partial_result
+    {
+        CallHandler value;
+    };
+    
+    using range_type = delegate<void(size_t begin, size_t end)>;
+    using merge_type = delegate<void(size_t into, size_t from)>;
+    
+    // The partial result of a run of chunks, which is that of its first
+    // chunk, so the pool can merge partial results without knowing their
+    // type.
+    struct chunk_span
+    {
+        chunk_span split() const
+        {
+            return { 0, merge_chunks };
+        }
         
-        for (auto& fn : fns)
+        void merge(chunk_span&& right)
         {
-            ((Impl*)this)->call_function(forEach, *fn, args...);
+            (*merge_chunks)(first, right.first);
         }
         
-        lock_type lock(((ImplBase*)this)->_mutex);
-        ((ImplBase*)this)->clean();
+        size_t              first;
+        const merge_type*   merge_chunks;
+    };
+    
+    using chunk_range_type = delegate<void(size_t begin, size_t end, chunk_span& span)>;
+    using parallel_for_type = void (*)(work_stealing_pool& pool, size_t count, size_t grain,
+                                       const range_type& fn);
+    using parallel_reduce_type = void (*)(work_stealing_pool& pool, size_t count,
+                                          chunk_span& result, const chunk_range_type& fn);
+    
+    template <class Pool>
+    static void parallel_for(work_stealing_pool& pool, size_t count, size_t grain,
+                             const range_type& fn)
+    {
+        static_cast<Pool&>(pool).parallel_for(count, grain, fn);
+    }
+    
+    template <class Pool>
+    static void parallel_reduce(work_stealing_pool& pool, size_t count,
+                                chunk_span& result, const chunk_range_type& fn)
+    {
+        static_cast<Pool&>(pool).parallel_reduce(count, 1, result, fn);
+    }
+    
+    size_t parallel_grain(size_t count) const
+    {
+        return std::max<size_t>(
+            count / (4 * (_parallel_workers.load(std::memory_order_relaxed) + 1)), 16);
+    }
+    
+    void call_parallel(work_stealing_pool& pool,
+                       std::nullptr_t,
+                       const snapshot_type& fns,
+                       event_details::param_type<Args>... args)
+    {
+        auto range = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                ((Impl*)this)->call_function(nullptr, fns[i], args...);
+            }
+        };
+        
+        // Referenced rather than copied, so the delegate holds it inline.
+        _parallel_for.load(std::memory_order_relaxed)(pool, fns.size(),
+                                                      parallel_grain(fns.size()),
+                                                      std::ref(range));
     }
+    
+    // The slots are split into chunks of a grain each. Each chunk but the
+    // first is given a partial result of its own, and the pool merges them
+    // pairwise, in order, as soon as both halves of a split are done, so the
+    // merging is spread across the pool too.
+    template <class CallHandler>
+    void call_parallel(work_stealing_pool& pool,
+                       CallHandler& combiner,
+                       const snapshot_type& fns,
+                       event_details::param_type<Args>... args)
+    {
+        size_t grain = parallel_grain(fns.size());
+        size_t chunks = (fns.size() + grain - 1) / grain;
+        
+        // Wrapped, so a combiner with an allocator_type isn't constructed with
+        // the event's allocator.
+        std::vector<partial_result<CallHandler>, Alloc<partial_result<CallHandler>>>
+            partials(((ImplBase*)this)->_allocator);
+        partials.reserve(chunks - 1);
+        
+        for (size_t i = 1; i < chunks; i++)
+        {
+            partials.push_back({combiner.split()});
+        }
+        
+        auto partial = [&](size_t chunk) -> CallHandler&
+        {
+            return chunk == 0 ? combiner : partials[chunk - 1].value;
+        };
+        
+        auto merge = [&](size_t into, size_t from)
+        {
+            partial(into).merge(std::move(partial(from)));
+        };
+        
+        // A run of chunks is called into the partial result of its first.
+        auto range = [&](size_t begin, size_t end, chunk_span& span)
+        {
+            span.first = begin;
+            
+            for (size_t chunk = begin; chunk < end; chunk++)
+            {
+                size_t last = std::min(fns.size(), (chunk + 1) * grain);
+                
+                for (size_t i = chunk * grain; i < last; i++)
+                {
+                    if (!((Impl*)this)->call_function(partial(begin), fns[i], args...))
+                    {
+                        break;
+                    }
+                }
+            }
+        };
+        
+        // Referenced rather than copied, so the delegates hold them inline.
+        merge_type merger(std::ref(merge));
+        chunk_span whole { 0, &merger };
+        
+        _parallel_reduce.load(std::memory_order_relaxed)(pool, chunks, whole, std::ref(range));
+    }
+    
+    // Must be called with the event's mutex held, whenever _sources changes.
+    // Returns the old snapshot, to be retired once the mutex is released.
+    event_details::retired* publish()
+    {
+        auto& sources = ((ImplBase*)this)->_sources;
+        
+        typename snapshot_type::vector_type fns(((ImplBase*)this)->_allocator);
+        fns.reserve(sources.size());
+        
+        sources.for_each(
+            [&](const typename ImplBase::source_type& source)
+            {
+                if (source._fn->connected())
+                {
+                    fns.push_back(source._fn);
+                }
+                
+                return true;
+            });
+        
+        return _snapshot.publish(fns.empty() ? nullptr :
+            event_details::allocate_object<snapshot_type>(fns.get_allocator(),
+                                                          std::move(fns)));
+    }
+    
+    publisher_type                      _snapshot;
+    std::atomic<work_stealing_pool*>    _pool {nullptr};
+    std::atomic<parallel_for_type>      _parallel_for {nullptr};
+    std::atomic<parallel_reduce_type>   _parallel_reduce {nullptr};
+    std::atomic<size_t>                 _parallel_workers {0};
+    std::atomic<size_t>                 _parallel_threshold {default_parallel_threshold};
 };
 
 
 template <class Impl,
     bool ThreadSafe,
     template <class S> class Alloc,
+    class Locking,
     class Result,
     class... Args>
-class fresh::event_base<Impl, Result(Args...), ThreadSafe, Alloc> :
+class fresh::event_base<Impl, Result(Args...), ThreadSafe, Alloc, Locking> :
     public event_caller<Impl,
-        event_base<Impl, Result(Args...), ThreadSafe, Alloc>,
+        event_base<Impl, Result(Args...), ThreadSafe, Alloc, Locking>,
         Result(Args...),
-        ThreadSafe, Alloc>
+        ThreadSafe, Alloc>,
+    public event_details::event_instrumentation<
+        event_base<Impl, Result(Args...), ThreadSafe, Alloc, Locking>,
+        FRESH_EVENT_INSTRUMENTATION>
 {
 public:
     
+    using function_type = Result(Args...);
+
     using connection_type = connection<ThreadSafe>;
     using mutex_type =
-        typename event_details::event_traits<ThreadSafe>::event_mutex_type;
+        typename event_details::event_traits<ThreadSafe, Locking>::event_mutex_type;
     using lock_type = std::lock_guard<mutex_type>;
-    using source_type = event_details::source<Result(Args...), ThreadSafe>;
-    using function_type = decltype(source_type::_fn);
+    using source_type = event_details::source<Result(Args...), ThreadSafe, Alloc>;
+    
+    using delegate_type = delegate<Result(Args...)>;
     
-    connection_type connect(const std::function<Result(Args...)>& fn)
+    // Connections, and thread-safe snapshots and functions, are allocated with
+    // this, as are callables too large for a delegate to hold inline.
+    using allocator_type = Alloc<char>;
+    
+    explicit event_base(const allocator_type& alloc = allocator_type()) :
+        _allocator(alloc),
+        _sources(alloc)
     {
-        lock_type lock(_mutex);
+        this->register_event();
+    }
+    
+    ~event_base()
+    {
+        this->unregister_event();
+        this->detach();
+        
+        // What a thread-safe event retires lives in memory from its allocator,
+        // which needn't outlive it, so unless that's the heap, it's reclaimed
+        // now. If the event is destroyed by a slot of another thread-safe
+        // event, that has to wait until the slot returns, and the allocator's
+        // memory must last until then.
+        if (ThreadSafe && !std::is_same<allocator_type, std::allocator<char>>::value)
+        {
+            _sources.clear();
+            retire(this->publish());
+            event_details::epoch_domain::instance().synchronize();
+        }
+    }
+    
+    connection_type connect(delegate_type fn)
+    {
+        handle_type handle;
+        event_details::retired* old;
+        
+        {
+            lock_type lock(_mutex);
+            
+            this->on_connect();
+            
+            handle = _sources.insert(source_type(std::move(fn), _allocator));
+            
+            old = this->publish();
+        }
+        
+        retire(old);
+        
+        return this->make_connection(handle);
+    }
+    
+    template <class Fn,
+        class = typename std::enable_if<
+            !std::is_same<typename std::decay<Fn>::type, delegate_type>::value &&
+            std::is_invocable_r<Result, typename std::decay<Fn>::type&, Args...>::value>::type>
+    connection_type connect(Fn&& fn)
+    {
+        return connect(delegate_type(std::allocator_arg, _allocator, std::forward<Fn>(fn)));
+    }
+    
+    // Connects each callable in [first, last), adding the connections to
+    // group. The mutex is taken, and a thread-safe event's slots republished,
+    // once for the whole range.
+    template <class It>
+    void connect_many(It first, It last, connection_group<ThreadSafe>& group)
+    {
+        std::vector<source_type, Alloc<source_type>> added(_allocator);
+        
+        for (; first != last; ++first)
+        {
+            added.push_back(source_type(to_delegate(*first), _allocator));
+        }
+        
+        std::vector<handle_type, Alloc<handle_type>> handles(_allocator);
+        handles.reserve(added.size());
         
-        source_type source(fn);
-        void* key = source._fn.get();
+        event_details::retired* old;
         
-        auto& value = _sources[key];
+        {
+            lock_type lock(_mutex);
+            
+            for (auto& source : added)
+            {
+                this->on_connect();
+                
+                handles.push_back(_sources.insert(std::move(source)));
+            }
+            
+            old = this->publish();
+        }
+        
+        retire(old);
         
-        value = std::move(source);
+        group.reserve(group.size() + handles.size());
         
-        return connection_type(key, this, &value);
+        for (auto& handle : handles)
+        {
+            group.add(this->make_connection(handle));
+        }
+    }
+    
+    // Connects a slot which is always called on the thread which owns
+    // context: emits from any thread post the call to context, without
+    // waiting for it, and it's made when that thread processes it. Once
+    // disconnected, calls already posted aren't made, unless the call is in
+    // progress on the owning thread.
+    template <class Fn, class Context,
+        class = typename std::enable_if<std::is_same<Context, thread_context>::value>::type>
+    connection_type connect(Fn&& fn, Context& context)
+    {
+        static_assert(ThreadSafe && std::is_void<Result>::value,
+            "Queued connections require a thread-safe event returning void.");
+        
+        // Only the connected slot owns the target, so it's destroyed on
+        // disconnection.
+        auto target = std::allocate_shared<delegate_type>(Alloc<delegate_type>(_allocator),
+            std::allocator_arg, _allocator, std::forward<Fn>(fn));
+        
+        return connect(
+            [target, &context](event_details::param_type<Args>... args)
+            {
+                std::weak_ptr<delegate_type> weak = target;
+                
+                context.execute(
+                    [weak, args...]() mutable
+                    {
+                        if (auto t = weak.lock())
+                        {
+                            (*t)(args...);
+                        }
+                    });
+            });
+    }
+    
+    allocator_type get_allocator() const
+    {
+        return _allocator;
+    }
+    
+    template <auto Method, class Owner>
+    connection_type connect(Owner& owner)
+    {
+        return connect(delegate_type::template bind<Method>(owner));
     }
     
 protected:
     
     friend event_caller<Impl,
-        event_base<Impl, Result(Args...), ThreadSafe, Alloc>,
+        event_base<Impl, Result(Args...), ThreadSafe, Alloc, Locking>,
         Result(Args...),
         ThreadSafe, Alloc>;
     
+    friend event_details::event_instrumentation<event_base, FRESH_EVENT_INSTRUMENTATION>;
+    
     mutex_type          _mutex;
     
 private:
     
-    void clean()
+    using handle_type = event_details::slot_handle;
+    
+    void close(const handle_type& handle) override
+    {
+        close(handle, std::integral_constant<bool, ThreadSafe>());
+    }
+    
+    // Nothing which could run code from outside the event, i.e. a slot or the
+    // destructor of something a slot captured, is done with the mutex held.
+    // Slots can connect to and disconnect from the event they're called by,
+    // or from any other event, so the mutex needn't be recursive.
+    void close(const handle_type& handle, std::true_type)
+    {
+        source_type removed;
+        event_details::retired* old;
+        
+        {
+            lock_type lock(_mutex);
+            
+            auto source = _sources.find(handle);
+            
+            if (!source)
+            {
+                return;
+            }
+            
+            this->on_disconnect();
+            
+            removed = std::move(*source);
+            _sources.erase(handle);
+            
+            old = this->publish();
+        }
+        
+        // The function was unpublished at the same time as the snapshot which
+        // listed it, so they're retired together.
+        removed.clear();
+        
+        event_details::retired* unpublished[] = { old, removed.release() };
+        event_details::epoch_domain::instance().retire(unpublished, 2);
+    }
+    
+    // The slot being called may be the one closed, so it's left in place
+    // until the table is unpinned.
+    void close(const handle_type& handle, std::false_type)
+    {
+        if (_sources.find(handle))
+        {
+            this->on_disconnect();
+            _sources.erase(handle);
+        }
+    }
+    
+    void close_many(const handle_type* handles, size_t count) override
+    {
+        close_many(handles, count, std::integral_constant<bool, ThreadSafe>());
+    }
+    
+    void close_many(const handle_type* handles, size_t count, std::true_type)
     {
-        if (!_can_clean) return;
+        std::vector<source_type, Alloc<source_type>> removed(_allocator);
+        removed.reserve(count);
+        
+        event_details::retired* old;
+        
+        {
+            lock_type lock(_mutex);
+            
+            for (size_t i = 0; i < count; i++)
+            {
+                auto source = _sources.find(handles[i]);
+                
+                if (source)
+                {
+                    this->on_disconnect();
+                    
+                    removed.push_back(std::move(*source));
+                    _sources.erase(handles[i]);
+                }
+            }
+            
+            if (removed.empty())
+            {
+                return;
+            }
+            
+            old = this->publish();
+        }
+        
+        std::vector<event_details::retired*, Alloc<event_details::retired*>>
+            unpublished(_allocator);
+        unpublished.reserve(removed.size() + 1);
+        unpublished.push_back(old);
         
-        for (auto& cnxn : _invalid_connections)
+        for (auto& source : removed)
         {
-            _sources.erase(cnxn._fn);
+            source.clear();
+            unpublished.push_back(source.release());
         }
         
-        _invalid_connections.clear();
+        event_details::epoch_domain::instance().retire(unpublished.data(),
+                                                       unpublished.size());
+    }
+    
+    void close_many(const handle_type* handles, size_t count, std::false_type)
+    {
+        this->close_each(handles, count,
+            [this](const handle_type& handle) { close(handle, std::false_type()); });
+    }
+    
+    delegate_type to_delegate(delegate_type fn)
+    {
+        return fn;
+    }
+    
+    template <class Fn,
+        class = typename std::enable_if<
+            !std::is_same<typename std::decay<Fn>::type, delegate_type>::value>::type>
+    delegate_type to_delegate(Fn&& fn)
+    {
+        return delegate_type(std::allocator_arg, _allocator, std::forward<Fn>(fn));
+    }
+    
+    static void retire(event_details::retired* old)
+    {
+        if (old)
+        {
+            event_details::epoch_domain::instance().retire(old);
+        }
     }
     
-    void close(connection_type& cnxn) override
+    // A non-thread-safe event's slots are changed without a lock, so they're
+    // only reported on the thread which created it.
+    void report_slots(event_report& out)
     {
+        out.thread_safe = ThreadSafe;
+        
+        if (!ThreadSafe && !this->on_creating_thread())
+        {
+            out.counts_only = true;
+            return;
+        }
+        
         lock_type lock(_mutex);
         
-        auto pos = _sources.find(cnxn._fn);
+        out.subscribers = _sources.size();
+        out.memory = sizeof(Impl) + _sources.memory();
         
-        if (pos != _sources.end())
+        if (ThreadSafe)
         {
-            pos->second._fn->clear();
-            _invalid_connections.insert(std::move(cnxn));
+            // Each function is allocated separately, and listed in a snapshot.
+            out.memory += _sources.size() *
+                (sizeof(event_details::allocated_function<Result(Args...), allocator_type>) +
+                 sizeof(void*));
         }
         
-        clean();
+        _sources.for_each(
+            [&](const source_type& source)
+            {
+                out.slots.emplace_back();
+                source.function().report(out.slots.back());
+                return true;
+            });
     }
     
-    using connection_set_type =
-        std::set
-            <connection_type, std::less<connection_type>, Alloc<connection_type>>;
+    using source_table_type = event_details::slot_table<source_type, Alloc>;
     
-    using source_map_alloc_type = Alloc<std::pair<void* const, source_type>>;
-
-    using source_map_type =
-        std::map<void*,
-            source_type,
-            std::less<void*>,
-            source_map_alloc_type>;
-    
-    bool                    _can_clean = true;
-    connection_set_type     _invalid_connections;
-    source_map_type         _sources;
+    allocator_type      _allocator;
+    source_table_type   _sources;
 };
 
-template<bool ThreadSafe, template <class T> class Alloc, class Result, class... Args>
-class fresh::event<Result(Args...), ThreadSafe, Alloc> :
+template<bool ThreadSafe,
+    template <class T> class Alloc,
+    class Combiner,
+    class Locking,
+    class Result,
+    class... Args>
+class fresh::event<Result(Args...), ThreadSafe, Alloc, Combiner, Locking> :
     public event_base
-        <event<Result(Args...), ThreadSafe, Alloc>, Result(Args...), ThreadSafe, Alloc>
+        <event<Result(Args...), ThreadSafe, Alloc, Combiner, Locking>, Result(Args...),
+            ThreadSafe, Alloc, Locking>
 {
 public:
     static_assert(!ThreadSafe ||
@@ -213,21 +762,29 @@ public:
 
     using base =
         event_base
-            <event<Result(Args...), ThreadSafe, Alloc>, Result(Args...), ThreadSafe, Alloc>;
+            <event<Result(Args...), ThreadSafe, Alloc, Combiner, Locking>, Result(Args...),
+                ThreadSafe, Alloc, Locking>;
+    
+    using combiner_type = Combiner;
+    using result_type = typename Combiner::result_type;
     
     using base::base;
     
-    auto operator()(Args... args) -> std::vector<Result, Alloc<Result>>
+    result_type operator()(event_details::param_type<Args>... args)
     {
-        std::vector<Result, Alloc<Result>> results;
-        
-        base::call(
-            [&](const Result& result)
-            {
-                results.push_back(result);
-            });
+        return combine(make_combiner(std::uses_allocator<Combiner,
+                                     typename base::allocator_type>()),
+                       args...);
+    }
+    
+    // Emits using the given combiner rather than the event's.
+    template <class CombinerType>
+    auto combine(CombinerType&& combiner, event_details::param_type<Args>... args)
+        -> decltype(combiner.result())
+    {
+        base::call(combiner, args...);
         
-        return results;
+        return combiner.result();
     }
     
 private:
@@ -240,18 +797,32 @@ private:
         template <class T> class AllocCaller>
     friend class event_caller;
 
-    void call_function(const std::function<void(const Result&)>& forEach,
+    // Combiners which allocate, like collect, use the event's allocator.
+    Combiner make_combiner(std::true_type) const
+    {
+        return Combiner(this->get_allocator());
+    }
+    
+    Combiner make_combiner(std::false_type) const
+    {
+        return Combiner();
+    }
+    
+    template <class CombinerType>
+    bool call_function(CombinerType& combiner,
                    const event_details::event_function<Result(Args...), ThreadSafe>& fn,
-                   Args... args)
+                   event_details::param_type<Args>... args)
     {
-        forEach(fn(args...));
+        return combiner(fn(args...));
     }
 };
 
-template<bool ThreadSafe, template <class T> class Alloc, class... Args>
-class fresh::event<void(Args...), ThreadSafe, Alloc> :
+template<bool ThreadSafe, template <class T> class Alloc, class Combiner, class Locking,
+    class... Args>
+class fresh::event<void(Args...), ThreadSafe, Alloc, Combiner, Locking> :
     public event_base
-        <event<void(Args...), ThreadSafe, Alloc>, void(Args...), ThreadSafe, Alloc>
+        <event<void(Args...), ThreadSafe, Alloc, Combiner, Locking>, void(Args...),
+            ThreadSafe, Alloc, Locking>
 {
     static_assert(!ThreadSafe ||
         is_thread_safe_function_type<void(Args...)>::value,
@@ -261,15 +832,37 @@ public:
     
     using base =
         event_base
-            <event<void(Args...), ThreadSafe, Alloc>, void(Args...), ThreadSafe, Alloc>;
+            <event<void(Args...), ThreadSafe, Alloc, Combiner, Locking>, void(Args...),
+                ThreadSafe, Alloc, Locking>;
     
     using base::base;
     
-    void operator()(Args... args)
+    using batch_type = batch<void(Args...)>;
+    
+    void operator()(event_details::param_type<Args>... args)
     {
         base::call(nullptr, args...);
     }
     
+    // Emits each item of a batch, but reads the slots only once for the
+    // whole batch, and gives each slot all of the items before calling the
+    // next one. A slot connected with connect_batch is called just once.
+    void emit_batch(const batch_type& items)
+    {
+        base::call_batch(items);
+    }
+    
+    // Connects fn, which takes a const batch_type&, to be called once with
+    // each batch emitted, and with a batch of one for any other emission.
+    template <class Fn>
+    typename base::connection_type connect_batch(Fn&& fn)
+    {
+        return base::connect(typename base::delegate_type(std::allocator_arg,
+            this->get_allocator(),
+            event_details::batch_slot<void(Args...), typename base::allocator_type>(
+                this->get_allocator(), std::forward<Fn>(fn))));
+    }
+    
 private:
     
     friend base;
@@ -281,11 +874,12 @@ private:
         template <class T> class AllocCaller>
     friend class event_caller;
     
-    void call_function(std::nullptr_t,
+    bool call_function(std::nullptr_t,
                    const event_details::event_function<void(Args...), ThreadSafe>& fn,
-                   Args... args)
+                   event_details::param_type<Args>... args)
     {
         fn(args...);
+        return true;
     }
 };
 
@@ -0,0 +1,65 @@
+//
+// allocation.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_allocation_hpp
+#define fresh_event_details_allocation_hpp
+
+#include "../config.hpp"
+
+#include <memory>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        // Like new T(args...), but with memory from alloc, which is rebound
+        // to T.
+        template <class T, class Allocator, class... A>
+        T* allocate_object(const Allocator& alloc, A&&... args)
+        {
+            using traits =
+                typename std::allocator_traits<Allocator>::template rebind_traits<T>;
+
+            typename traits::allocator_type a(alloc);
+
+            T* p = traits::allocate(a, 1);
+
+            try
+            {
+                ::new ((void*)p) T(std::forward<A>(args)...);
+            }
+            catch (...)
+            {
+                traits::deallocate(a, p, 1);
+                throw;
+            }
+
+            return p;
+        }
+
+        // Destroys an object made by allocate_object. alloc is copied first,
+        // in case it belongs to the object.
+        template <class T, class Allocator>
+        void destroy_object(Allocator alloc, T* p)
+        {
+            using traits =
+                typename std::allocator_traits<Allocator>::template rebind_traits<T>;
+
+            typename traits::allocator_type a(alloc);
+
+            p->~T();
+            traits::deallocate(a, p, 1);
+        }
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+#endif
@@ -0,0 +1,190 @@
+//
+// bounded_queue.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_bounded_queue_hpp
+#define fresh_event_details_bounded_queue_hpp
+
+#include "../config.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        template <class T, template <class S> class Alloc>
+        class bounded_queue;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// A fixed-capacity, lock-free, multi-producer multi-consumer FIFO. Each cell
+// carries a sequence number which tells producers and consumers whose turn it
+// is, so neither blocks the other and nothing is allocated after construction.
+template <class T, template <class S> class Alloc>
+class fresh::event_details::bounded_queue
+{
+public:
+
+    // The capacity is rounded up to a power of two.
+    bounded_queue(size_t capacity, const Alloc<char>& alloc = Alloc<char>()) :
+        _cells(round_up(capacity), alloc),
+        _mask(_cells.size() - 1)
+    {
+        for (size_t i = 0; i < _cells.size(); i++)
+        {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bounded_queue(const bounded_queue& other) = delete;
+
+    ~bounded_queue()
+    {
+        while (try_pop([](T&&) {}))
+        {
+        }
+    }
+
+    bounded_queue& operator= (const bounded_queue& other) = delete;
+
+    size_t capacity() const
+    {
+        return _cells.size();
+    }
+
+    bool empty() const
+    {
+        size_t pos = _head.load(std::memory_order_acquire);
+        auto& cell = _cells[pos & _mask];
+
+        return cell.sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    template <class U>
+    bool try_push(U&& value)
+    {
+        size_t pos = _tail.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& cell = _cells[pos & _mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+            if (diff == 0)
+            {
+                if (_tail.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+                {
+                    new (&cell.storage) T(std::forward<U>(value));
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Removes the oldest value, if any, and passes it to fn. The value is
+    // removed even if fn throws.
+    template <class Fn>
+    bool try_pop(Fn&& fn)
+    {
+        size_t pos = _head.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& cell = _cells[pos & _mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+
+            if (diff == 0)
+            {
+                if (_head.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+                {
+                    pop_guard guard {cell, pos + _mask + 1};
+
+                    fn(std::move(guard.value()));
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+
+    struct cell
+    {
+        std::atomic<size_t>                                             sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type      storage;
+    };
+
+    // Destroys a popped value and hands its cell back to the producers, once
+    // the consumer is done with it or has thrown.
+    struct pop_guard
+    {
+        ~pop_guard()
+        {
+            value().~T();
+            popped.sequence.store(sequence, std::memory_order_release);
+        }
+
+        T& value()
+        {
+            return *reinterpret_cast<T*>(&popped.storage);
+        }
+
+        cell&   popped;
+        size_t  sequence;
+    };
+
+    static size_t round_up(size_t capacity)
+    {
+        size_t result = 1;
+
+        while (result < capacity)
+        {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    using cell_vector_type = std::vector<cell, Alloc<cell>>;
+
+    cell_vector_type                    _cells;
+    const size_t                        _mask;
+    alignas(64) std::atomic<size_t>     _tail {0};
+    alignas(64) std::atomic<size_t>     _head {0};
+};
+
+#endif
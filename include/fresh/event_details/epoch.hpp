@@ -0,0 +1,506 @@
+//
+// epoch.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_epoch_hpp
+#define fresh_event_details_epoch_hpp
+
+#include "../config.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        class retired;
+
+        class thread_record;
+
+        class epoch_domain;
+
+        class epoch_guard;
+
+        class call_guard;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// Base for anything that has been unpublished but may still be in use by a
+// reader, and so must have its destruction deferred.
+class fresh::event_details::retired
+{
+public:
+
+    // Destroys the object and frees its memory. Override this for objects
+    // which weren't allocated with new.
+    virtual void destroy()
+    {
+        delete this;
+    }
+
+protected:
+
+    virtual ~retired() = default;
+};
+
+// The state one thread shares with the others: the epoch it entered its
+// outermost read-side critical section in, the functions it's calling, and
+// what it has retired. Only the owning thread writes to the first two, so
+// entering and leaving a critical section doesn't contend with other threads,
+// and its retired list is only locked by anyone else when synchronizing.
+class alignas(64) fresh::event_details::thread_record
+{
+public:
+
+    static const unsigned max_calls = 8;
+
+private:
+
+    friend epoch_domain;
+    friend epoch_guard;
+    friend call_guard;
+
+    using retired_list_type = std::vector<std::pair<uint64_t, retired*>>;
+
+    std::atomic<uint64_t>       _epoch {0};
+    std::atomic<const void*>    _calls[max_calls] = {};
+    std::atomic<unsigned>       _overflow {0};
+    std::atomic<bool>           _in_use {true};
+    thread_record*              _next = nullptr;
+    unsigned                    _depth = 0;
+    unsigned                    _call_depth = 0;
+
+    // Kept apart from the above, which other threads read. _reclaiming is
+    // odd while the thread is destroying what it has taken off any list.
+    alignas(64) std::mutex      _retired_mutex;
+    retired_list_type           _retired;
+    size_t                      _reclaim_at = 0;
+    std::atomic<uint64_t>       _reclaiming {0};
+    unsigned                    _reclaim_depth = 0;
+};
+
+// Epoch-based reclamation shared by all thread-safe events. Emitters enter a
+// critical section before reading anything that can be retired, and objects
+// that have been unpublished are only destroyed once every thread which might
+// still see them has left its critical section.
+//
+// Each thread retires to a list of its own, and only scans the other threads'
+// epochs once that list has grown by a batch, so retiring takes no lock
+// shared with other threads and costs O(1) amortized.
+class fresh::event_details::epoch_domain
+{
+public:
+
+    static constexpr size_t reclaim_batch = 32;
+
+    static epoch_domain& instance()
+    {
+        // Intentionally leaked, so it outlives any thread using it.
+        static epoch_domain* domain = new epoch_domain();
+        return *domain;
+    }
+
+    thread_record& record()
+    {
+        thread_local holder h(*this);
+        return *h.record;
+    }
+
+    void retire(retired* value)
+    {
+        retire(&value, 1);
+    }
+
+    // Retires several things at once, skipping any which are null, e.g. what
+    // a disconnection unpublished.
+    void retire(retired* const* values, size_t count)
+    {
+        thread_record& self = record();
+        bool full;
+
+        {
+            std::lock_guard<std::mutex> lock(self._retired_mutex);
+
+            uint64_t epoch = _epoch.load();
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (values[i])
+                {
+                    self._retired.emplace_back(epoch, values[i]);
+                }
+            }
+
+            full = self._retired.size() >= self._reclaim_at;
+        }
+
+        if (full)
+        {
+            reclaim(self);
+        }
+    }
+
+    // Waits until every other thread has left any critical section it was in,
+    // then destroys whatever can be, and waits for other threads to finish
+    // destroying what they'd already taken. Things retired after the calling
+    // thread entered a critical section of its own, or while it's destroying
+    // something itself, are left for later.
+    void synchronize()
+    {
+        uint64_t now = _epoch.fetch_add(1) + 1;
+
+        thread_record* self = &record();
+
+        for (auto r = _records.load(); r; r = r->_next)
+        {
+            if (r == self)
+            {
+                continue;
+            }
+
+            for (;;)
+            {
+                uint64_t epoch = r->_epoch.load();
+
+                if (epoch == 0 || epoch >= now)
+                {
+                    break;
+                }
+
+                std::this_thread::yield();
+            }
+        }
+
+        // Threads which have exited leave their lists behind, so every list
+        // is swept, not just the calling thread's.
+        uint64_t oldest = oldest_epoch();
+        retired_list_type reclaimed;
+
+        bool nested = self->_reclaim_depth > 0;
+
+        begin_reclaim(*self);
+
+        for (auto r = _records.load(); r; r = r->_next)
+        {
+            std::lock_guard<std::mutex> lock(r->_retired_mutex);
+            take(r->_retired, oldest, reclaimed);
+        }
+
+        destroy(reclaimed);
+
+        end_reclaim(*self);
+
+        // Another thread may have taken something off a list before this one
+        // swept it. Two threads each synchronizing from within a destroy
+        // would wait for each other, so a nested call doesn't wait.
+        if (nested)
+        {
+            return;
+        }
+
+        for (auto r = _records.load(); r; r = r->_next)
+        {
+            uint64_t reclaiming = r->_reclaiming.load();
+
+            while (r != self && reclaiming % 2 != 0 && r->_reclaiming.load() == reclaiming)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Waits until no other thread is calling fn. The calling thread might be
+    // calling it itself, but it can't wait for that.
+    void wait_until_not_called(const void* fn)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        thread_record* self = &record();
+
+        for (auto r = _records.load(); r; r = r->_next)
+        {
+            if (r == self)
+            {
+                continue;
+            }
+
+            while (is_calling(*r, fn))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Whether the calling thread is calling fn.
+    bool calling(const void* fn)
+    {
+        return is_calling(record(), fn);
+    }
+
+private:
+
+    friend epoch_guard;
+
+    struct holder
+    {
+        holder(epoch_domain& domain) :
+            domain(domain),
+            record(domain.acquire())
+        {
+        }
+
+        // What can't be reclaimed yet is left to the record's next owner, or
+        // to synchronize.
+        ~holder()
+        {
+            domain.reclaim(*record);
+            record->_in_use.store(false, std::memory_order_release);
+        }
+
+        epoch_domain&   domain;
+        thread_record*  record;
+    };
+
+    using retired_list_type = thread_record::retired_list_type;
+
+    epoch_domain() = default;
+
+    thread_record* acquire()
+    {
+        for (auto r = _records.load(); r; r = r->_next)
+        {
+            bool in_use = false;
+
+            if (!r->_in_use.load(std::memory_order_relaxed) &&
+                r->_in_use.compare_exchange_strong(in_use, true))
+            {
+                return r;
+            }
+        }
+
+        auto r = new thread_record();
+
+        r->_next = _records.load();
+
+        while (!_records.compare_exchange_weak(r->_next, r))
+        {
+        }
+
+        return r;
+    }
+
+    // Marks the calling thread as destroying what it takes off a list from now
+    // on. Must be called before taking anything, with r being the calling
+    // thread's record.
+    static void begin_reclaim(thread_record& r)
+    {
+        if (r._reclaim_depth++ == 0)
+        {
+            r._reclaiming.store(r._reclaiming.load(std::memory_order_relaxed) + 1);
+        }
+    }
+
+    static void end_reclaim(thread_record& r)
+    {
+        if (--r._reclaim_depth == 0)
+        {
+            r._reclaiming.store(r._reclaiming.load(std::memory_order_relaxed) + 1,
+                                std::memory_order_release);
+        }
+    }
+
+    // Destroying these could retire something else, so the lock can't be held.
+    static void destroy(retired_list_type& reclaimed)
+    {
+        for (auto& entry : reclaimed)
+        {
+            entry.second->destroy();
+        }
+    }
+
+    static bool is_calling(const thread_record& r, const void* fn)
+    {
+        if (r._overflow.load() > 0)
+        {
+            return true;
+        }
+
+        for (auto& call : r._calls)
+        {
+            if (call.load() == fn)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Destroys what r, the calling thread's record, has retired that no reader
+    // can still see. The epoch is advanced first, so that what's retired from
+    // now on can be told apart from what readers already in a critical section
+    // might see. If much is still in use, the next sweep waits until the list
+    // has doubled, so that a long critical section doesn't make every retire
+    // scan the list.
+    void reclaim(thread_record& r)
+    {
+        _epoch.fetch_add(1);
+
+        uint64_t oldest = oldest_epoch();
+        retired_list_type reclaimed;
+
+        begin_reclaim(r);
+
+        {
+            std::lock_guard<std::mutex> lock(r._retired_mutex);
+
+            take(r._retired, oldest, reclaimed);
+
+            r._reclaim_at = std::max(reclaim_batch, 2 * r._retired.size());
+        }
+
+        destroy(reclaimed);
+
+        end_reclaim(r);
+    }
+
+    uint64_t oldest_epoch()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        uint64_t oldest = UINT64_MAX;
+
+        for (auto r = _records.load(); r; r = r->_next)
+        {
+            uint64_t epoch = r->_epoch.load();
+
+            if (epoch != 0 && epoch < oldest)
+            {
+                oldest = epoch;
+            }
+        }
+
+        return oldest;
+    }
+
+    // Anything retired before the oldest critical section began can no
+    // longer be seen by any reader. The list's lock must be held.
+    static void take(retired_list_type& list, uint64_t oldest, retired_list_type& reclaimed)
+    {
+        size_t kept = 0;
+
+        for (auto& entry : list)
+        {
+            if (entry.first < oldest)
+            {
+                reclaimed.push_back(entry);
+            }
+            else
+            {
+                list[kept++] = entry;
+            }
+        }
+
+        list.resize(kept);
+    }
+
+    std::atomic<uint64_t>           _epoch {1};
+    std::atomic<thread_record*>     _records {nullptr};
+};
+
+// A read-side critical section. Nothing retired after it begins will be
+// destroyed before it ends. Critical sections can be nested.
+class fresh::event_details::epoch_guard
+{
+public:
+
+    epoch_guard() :
+        _record(epoch_domain::instance().record())
+    {
+        if (_record._depth++ == 0)
+        {
+            auto& domain = epoch_domain::instance();
+
+            // Sequentially consistent, so that whatever is unpublished after
+            // this reader can see it is retired with an epoch at least as
+            // late.
+            _record._epoch.store(domain._epoch.load(), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    epoch_guard(const epoch_guard& other) = delete;
+
+    ~epoch_guard()
+    {
+        if (--_record._depth == 0)
+        {
+            _record._epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    epoch_guard& operator= (const epoch_guard& other) = delete;
+
+private:
+
+    thread_record& _record;
+};
+
+// Publishes that the current thread is calling a function, for the benefit of
+// epoch_domain::wait_until_not_called.
+class fresh::event_details::call_guard
+{
+public:
+
+    call_guard(const void* fn) :
+        _record(epoch_domain::instance().record())
+    {
+        if (_record._call_depth < thread_record::max_calls)
+        {
+            _record._calls[_record._call_depth].store(fn);
+        }
+        else
+        {
+            _record._overflow.fetch_add(1);
+        }
+
+        ++_record._call_depth;
+    }
+
+    call_guard(const call_guard& other) = delete;
+
+    ~call_guard()
+    {
+        if (--_record._call_depth < thread_record::max_calls)
+        {
+            _record._calls[_record._call_depth].store(nullptr,
+                                                      std::memory_order_release);
+        }
+        else
+        {
+            _record._overflow.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    call_guard& operator= (const call_guard& other) = delete;
+
+private:
+
+    thread_record& _record;
+};
+
+#endif
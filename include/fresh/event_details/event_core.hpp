@@ -0,0 +1,309 @@
+//
+// event_core.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_event_core_hpp
+#define fresh_event_details_event_core_hpp
+
+#include "../config.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <thread>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        class event_core;
+
+        class event_core_table;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// What a connection refers to instead of its event, so that it can tell
+// whether the event still exists. Cores are never freed; each time one is
+// reused by a new event its generation changes, which invalidates every
+// connection to the previous one.
+class fresh::event_details::event_core
+{
+public:
+
+    // Enters a core, if its event has the given generation, for as long as it
+    // exists. The event can't be destroyed meanwhile, except by the thread
+    // which entered, e.g. from the destructor of a slot it disconnected.
+    class entry
+    {
+    public:
+
+        entry(event_core& core, uint32_t generation) :
+            _core(core),
+            _entered(core.enter(generation)),
+            _next(top())
+        {
+            top() = this;
+        }
+
+        entry(const entry& other) = delete;
+
+        ~entry()
+        {
+            top() = _next;
+
+            if (_entered)
+            {
+                _core.leave();
+            }
+        }
+
+        entry& operator= (const entry& other) = delete;
+
+        explicit operator bool() const
+        {
+            return _entered;
+        }
+
+    private:
+
+        friend event_core;
+
+        // The innermost entry of the calling thread. Every entry is pushed and
+        // popped, even one which didn't enter, so that the pointer to it is
+        // always reset when it goes out of scope.
+        static entry*& top()
+        {
+            thread_local entry* innermost = nullptr;
+            return innermost;
+        }
+
+        event_core& _core;
+        bool        _entered;
+        entry*      _next;
+    };
+
+    uint32_t generation() const
+    {
+        return (uint32_t)(_state.load() >> 32);
+    }
+
+    void* event() const
+    {
+        return _event.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    friend event_core_table;
+
+    static const uint64_t count_mask = 0xffffffff;
+
+    bool enter(uint32_t generation)
+    {
+        if ((uint32_t)(_state.fetch_add(1) >> 32) == generation)
+        {
+            return true;
+        }
+
+        _state.fetch_sub(1);
+        return false;
+    }
+
+    void leave()
+    {
+        _state.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Waits until nobody else has entered, then invalidates the generation.
+    // Entries of the calling thread are further up its stack, so they're left
+    // to leave once it returns to them.
+    void retire()
+    {
+        uint64_t own = 0;
+
+        for (auto e = entry::top(); e; e = e->_next)
+        {
+            if (e->_entered && &e->_core == this)
+            {
+                ++own;
+            }
+        }
+
+        uint64_t expected = (_state.load() & ~count_mask) | own;
+
+        while (!_state.compare_exchange_weak(expected,
+                                             expected + (uint64_t(1) << 32)))
+        {
+            expected = (expected & ~count_mask) | own;
+            std::this_thread::yield();
+        }
+
+        _event.store(nullptr, std::memory_order_relaxed);
+    }
+
+    // The generation in the high half, and the number of threads which have
+    // entered in the low half.
+    std::atomic<uint64_t>   _state {0};
+    std::atomic<void*>      _event {nullptr};
+    std::atomic<uint32_t>   _next_free {0};
+};
+
+// The process-wide store of event cores, which neither locks nor, for the
+// first 1024 events alive at once, allocates. Cores are kept in blocks, each
+// twice the size of the previous one, which are allocated when first needed
+// and never freed. Released cores go on a lock-free list for reuse.
+class fresh::event_details::event_core_table
+{
+public:
+
+    static const uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    static event_core_table& instance()
+    {
+        // Never destroyed, so events can be destroyed during exit.
+        alignas(event_core_table) static unsigned char storage[sizeof(event_core_table)];
+        static event_core_table* table = new (storage) event_core_table();
+        return *table;
+    }
+
+    event_core& at(uint32_t index)
+    {
+        uint32_t block = block_of(index);
+
+        return _blocks[block].load(std::memory_order_acquire)[index - block_start(block)];
+    }
+
+    uint32_t acquire(void* event)
+    {
+        uint32_t index = pop_free();
+
+        if (index == npos)
+        {
+            uint64_t next = _size.fetch_add(1, std::memory_order_relaxed);
+
+            if (next >= block_start(max_blocks))
+            {
+                throw std::bad_alloc();
+            }
+
+            index = (uint32_t)next;
+            reserve(block_of(index));
+        }
+
+        at(index)._event.store(event, std::memory_order_relaxed);
+
+        return index;
+    }
+
+    void release(uint32_t index)
+    {
+        auto& core = at(index);
+
+        core.retire();
+
+        push_free(index);
+    }
+
+private:
+
+    static const uint32_t first_block_size = 1024;
+
+    // Enough blocks for every index but the last thousand or so.
+    static const uint32_t max_blocks = 22;
+
+    event_core_table()
+    {
+        _blocks[0].store(_first, std::memory_order_relaxed);
+    }
+
+    static uint32_t block_start(uint32_t block)
+    {
+        return first_block_size * ((uint32_t(1) << block) - 1);
+    }
+
+    static uint32_t block_of(uint32_t index)
+    {
+        uint32_t n = index / first_block_size + 1;
+        uint32_t block = 0;
+
+        while (n >>= 1)
+        {
+            ++block;
+        }
+
+        return block;
+    }
+
+    void reserve(uint32_t block)
+    {
+        if (_blocks[block].load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        auto cores = new event_core[first_block_size << block];
+        event_core* expected = nullptr;
+
+        // Another thread may have allocated it first.
+        if (!_blocks[block].compare_exchange_strong(expected, cores,
+                                                    std::memory_order_acq_rel))
+        {
+            delete[] cores;
+        }
+    }
+
+    // The free list's head is tagged with a count of the changes made to it,
+    // so a core popped and pushed again meanwhile doesn't go unnoticed.
+    static uint64_t tagged(uint64_t head, uint32_t index)
+    {
+        return ((head >> 32) + 1) << 32 | index;
+    }
+
+    uint32_t pop_free()
+    {
+        uint64_t head = _free.load(std::memory_order_acquire);
+
+        while ((uint32_t)head != npos)
+        {
+            uint32_t index = (uint32_t)head;
+            uint32_t next = at(index)._next_free.load(std::memory_order_relaxed);
+
+            if (_free.compare_exchange_weak(head, tagged(head, next),
+                                            std::memory_order_acquire))
+            {
+                return index;
+            }
+        }
+
+        return npos;
+    }
+
+    void push_free(uint32_t index)
+    {
+        auto& core = at(index);
+        uint64_t head = _free.load(std::memory_order_relaxed);
+
+        do
+        {
+            core._next_free.store((uint32_t)head, std::memory_order_relaxed);
+        }
+        while (!_free.compare_exchange_weak(head, tagged(head, index),
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+    }
+
+    std::atomic<event_core*>    _blocks[max_blocks] = {};
+    std::atomic<uint64_t>       _free {npos};
+    std::atomic<uint64_t>       _size {0};
+    event_core                  _first[first_block_size];
+};
+
+#endif
@@ -8,15 +8,21 @@
 #ifndef fresh_event_details_event_function_hpp
 #define fresh_event_details_event_function_hpp
 
-#include "source_base.hpp"
+#include "epoch.hpp"
 #include "traits.hpp"
-#include "../threads.hpp"
+#include "../config.hpp"
+#include "../batch.hpp"
+#include "../delegate.hpp"
+#include "instrumentation_hooks.hpp"
 
-#include <cassert>
-#include <functional>
+#include <atomic>
+#include <tuple>
+#include <utility>
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+    
     namespace event_details
     {
         template<class Fn, bool ThreadSafe>
@@ -25,32 +31,67 @@ namespace fresh
         template<class Fn, bool ThreadSafe>
         class event_function;
     }
+    
+    FRESH_END_NAMESPACE
 }
 
 template<class Fn, bool ThreadSafe>
-class fresh::event_details::event_function_base
+class fresh::event_details::event_function_base :
+    public slot_instrumentation<FRESH_EVENT_INSTRUMENTATION>
 {
 public:
     
-    using mutex_type = typename event_traits<ThreadSafe>::function_mutex_type;
-    using read_lock_type = fresh::read_lock<mutex_type>;
-    using write_lock_type = fresh::write_lock<mutex_type>;
+    event_function_base()
+    {
+    }
     
-    event_function_base(const std::function<Fn>& fn) :
-    _fn(fn)
+    event_function_base(delegate<Fn> fn) :
+    _fn(std::move(fn))
+    {
+    }
+
+protected:
+    
+    delegate<Fn>       _fn;
+};
+
+// A thread-safe function is only destroyed once it has been retired and no
+// emitter can still see it. Disconnecting it clears _connected and then waits
+// until no other thread is calling it, so it isn't called after that returns,
+// and its callable is destroyed then unless the disconnecting thread is
+// calling it.
+template<class Fn>
+class fresh::event_details::event_function_base<Fn, true> :
+    public retired,
+    public slot_instrumentation<FRESH_EVENT_INSTRUMENTATION>
+{
+public:
+    
+    event_function_base(delegate<Fn> fn) :
+    _fn(std::move(fn))
     {
     }
     
     void clear()
     {
-        write_lock_type lock(_mutex);
-        _fn = nullptr;
+        _connected.store(false);
+        epoch_domain::instance().wait_until_not_called(this);
+
+        if (!epoch_domain::instance().calling(this))
+        {
+            _fn = nullptr;
+        }
+    }
+    
+    bool connected() const
+    {
+        return _connected.load();
     }
 
 protected:
     
-    std::function<Fn>  _fn;
-    mutable mutex_type _mutex;
+    delegate<Fn>        _fn;
+    std::atomic<bool>   _connected {true};
 };
 
 
@@ -61,19 +102,44 @@ class fresh::event_details::event_function<Result(Args...), ThreadSafe> :
 public:
     
     using base = event_function_base<Result(Args...), ThreadSafe>;
-    using mutex_type = typename base::mutex_type;
-    using read_lock_type = typename base::read_lock_type;
-    using write_lock_type = typename base::write_lock_type;
     
     using base::base;
     
     Result
-    operator() (Args... args) const
+    operator() (param_type<Args>... args) const
     {
-        read_lock_type   lock(base::_mutex);
-        
         if (base::_fn)
         {
+            typename base::scope timing(*this);
+            
+            return base::_fn(args...);
+        }
+        else
+        {
+            return Result();
+        }
+    }
+};
+
+template<class Result, class... Args>
+class fresh::event_details::event_function<Result(Args...), true> :
+    public event_function_base<Result(Args...), true>
+{
+public:
+    
+    using base = event_function_base<Result(Args...), true>;
+    
+    using base::base;
+    
+    Result
+    operator() (param_type<Args>... args) const
+    {
+        call_guard guard(this);
+        
+        if (base::connected())
+        {
+            typename base::scope timing(*this);
+            
             return base::_fn(args...);
         }
         else
@@ -90,22 +156,110 @@ class fresh::event_details::event_function<void(Args...), ThreadSafe> :
 public:
     
     using base = event_function_base<void(Args...), ThreadSafe>;
-    using mutex_type = typename base::mutex_type;
-    using read_lock_type = typename base::read_lock_type;
-    using write_lock_type = typename base::write_lock_type;
 
     using base::base;
 
     void
-    operator() (Args... args) const
+    operator() (param_type<Args>... args) const
     {
-        read_lock_type   lock(base::_mutex);
-        
         if (base::_fn)
         {
+            typename base::scope timing(*this);
+            
             base::_fn(args...);
         }
     }
+    
+    // Calls the function with each item in turn, or just once with all of
+    // them if it was connected with connect_batch. Stops once erased() says
+    // it's been disconnected.
+    template <class Allocator, class Erased>
+    void
+    call_batch(const batch<void(Args...)>& items, Erased erased) const
+    {
+        if (!base::_fn)
+        {
+            return;
+        }
+        
+        if (auto slot = base::_fn.template target<batch_slot<void(Args...), Allocator>>())
+        {
+            typename base::scope timing(*this);
+            
+            (*slot)(items);
+            return;
+        }
+        
+        for (auto& item : items)
+        {
+            if (erased())
+            {
+                break;
+            }
+            
+            typename base::scope timing(*this);
+            
+            std::apply(base::_fn, item);
+        }
+    }
+};
+
+template<class... Args>
+class fresh::event_details::event_function<void(Args...), true> :
+    public event_function_base<void(Args...), true>
+{
+public:
+    
+    using base = event_function_base<void(Args...), true>;
+
+    using base::base;
+
+    void
+    operator() (param_type<Args>... args) const
+    {
+        call_guard guard(this);
+        
+        if (base::connected())
+        {
+            typename base::scope timing(*this);
+            
+            base::_fn(args...);
+        }
+    }
+    
+    // Calls the function with each item in turn, or once with all of them,
+    // until it's disconnected. Disconnecting waits for the call in progress.
+    template <class Allocator, class Erased>
+    void
+    call_batch(const batch<void(Args...)>& items, Erased) const
+    {
+        call_guard guard(this);
+        
+        if (!base::connected())
+        {
+            return;
+        }
+        
+        if (auto slot = base::_fn.template target<batch_slot<void(Args...), Allocator>>())
+        {
+            typename base::scope timing(*this);
+            
+            (*slot)(items);
+            return;
+        }
+        
+        for (auto& item : items)
+        {
+            if (!base::connected())
+            {
+                break;
+            }
+            
+            typename base::scope timing(*this);
+            
+            std::apply(base::_fn, item);
+        }
+    }
 };
 
 #endif
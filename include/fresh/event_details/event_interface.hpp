@@ -8,28 +8,106 @@
 #ifndef fresh_event_details_event_interface_hpp
 #define fresh_event_details_event_interface_hpp
 
+#include "event_core.hpp"
+#include "slot_table.hpp"
+#include "../config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+
     namespace event_details
     {
         template <bool ThreadSafe>
         class event_interface;
     }
-    
+
     template <bool ThreadSafe>
     class connection;
+
+    template <bool ThreadSafe>
+    class connection_group;
+
+    FRESH_END_NAMESPACE
 }
 
 template <bool ThreadSafe>
 class fresh::event_details::event_interface
 {
 public:
-    virtual ~event_interface() = default;
+
+    event_interface() :
+        _core(event_core_table::instance().acquire(this)),
+        _generation(event_core_table::instance().at(_core).generation())
+    {
+    }
+
+    event_interface(const event_interface& other) = delete;
+
+    virtual ~event_interface()
+    {
+        detach();
+    }
+
+    event_interface& operator= (const event_interface& other) = delete;
+
+protected:
+
+    connection<ThreadSafe> make_connection(const slot_handle& handle)
+    {
+        return connection<ThreadSafe>(_core, _generation, handle);
+    }
+
+    // Invalidates every connection to the event, waiting for any disconnection
+    // in progress to finish. Events must call this before destroying their
+    // slots.
+    void detach()
+    {
+        if (_core != event_core_table::npos)
+        {
+            event_core_table::instance().release(_core);
+            _core = event_core_table::npos;
+        }
+    }
+
+    // Calls close on each handle in turn, stopping if one of them destroys
+    // the event, e.g. from the destructor of something a slot captured.
+    template <class Close>
+    void close_each(const slot_handle* handles, size_t count, Close close)
+    {
+        uint32_t core = _core;
+        uint32_t generation = _generation;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            close(handles[i]);
+
+            if (event_core_table::instance().at(core).generation() != generation)
+            {
+                return;
+            }
+        }
+    }
 
 private:
+
     friend connection<ThreadSafe>;
-    
-    virtual void close(connection<ThreadSafe>& cnxn) = 0;
+    friend connection_group<ThreadSafe>;
+
+    virtual void close(const slot_handle& handle) = 0;
+
+    // Events which can close several slots more cheaply than one at a time
+    // override this.
+    virtual void close_many(const slot_handle* handles, size_t count)
+    {
+        close_each(handles, count, [this](const slot_handle& handle) { close(handle); });
+    }
+
+    uint32_t _core;
+    uint32_t _generation;
 };
 
 #endif
@@ -0,0 +1,128 @@
+//
+// instrumentation_hooks.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_instrumentation_hooks_hpp
+#define fresh_event_details_instrumentation_hooks_hpp
+
+#include "../config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    struct slot_report;
+
+    struct event_report;
+
+    namespace event_details
+    {
+        template <bool Enabled>
+        class slot_instrumentation;
+
+        template <class Impl, bool Enabled>
+        class event_instrumentation;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+struct fresh::slot_report
+{
+    // Bucket i counts calls which took less than 2^(i+1) ns, and at least 2^i
+    // ns unless i is 0. The last bucket also counts anything slower.
+    static const size_t buckets = 32;
+
+    uint64_t calls = 0;
+    uint64_t histogram[buckets] = {};
+};
+
+struct fresh::event_report
+{
+    const void*                 address = nullptr;
+    std::string                 name;
+    std::string                 signature;
+    bool                        thread_safe = false;
+    size_t                      subscribers = 0;
+    size_t                      memory = 0;
+    uint64_t                    emits = 0;
+    uint64_t                    connects = 0;
+    uint64_t                    disconnects = 0;
+    std::vector<slot_report>    slots;
+
+    // Set when a non-thread-safe event is reported from a thread other than
+    // the one which created it, in which case only its counts are known, and
+    // subscribers, memory and slots are left empty.
+    bool                        counts_only = false;
+};
+
+template <bool Enabled>
+class fresh::event_details::slot_instrumentation
+{
+public:
+
+    class scope
+    {
+    public:
+
+        scope(const slot_instrumentation&)
+        {
+        }
+    };
+
+    void report(slot_report&) const
+    {
+    }
+};
+
+// The part of an event which is instrumented. Impl provides the subscriber
+// count, memory footprint and slot reports with report_slots.
+template <class Impl, bool Enabled>
+class fresh::event_details::event_instrumentation
+{
+public:
+
+    void set_name(const char*)
+    {
+    }
+
+protected:
+
+    void register_event()
+    {
+    }
+
+    void unregister_event()
+    {
+    }
+
+    void on_emit(uint64_t = 1)
+    {
+    }
+
+    void on_connect()
+    {
+    }
+
+    void on_disconnect()
+    {
+    }
+};
+
+// What's instrumented, the registry and the reports' output, is only included
+// when it's enabled.
+#if FRESH_EVENT_INSTRUMENTATION
+
+    #include "../instrumentation.hpp"
+
+#endif
+
+#endif
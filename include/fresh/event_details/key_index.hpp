@@ -0,0 +1,284 @@
+//
+// key_index.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_key_index_hpp
+#define fresh_event_details_key_index_hpp
+
+#include "allocation.hpp"
+#include "epoch.hpp"
+#include "../config.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        template <class Key, class Value, class Hash, template <class T> class Alloc>
+        class key_index;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// A hash table which readers search without locking, from within an
+// epoch_guard. Each of its slots holds an immutable chain of the keys which
+// hash to it, so adding or removing a key only replaces that key's chain, and
+// the old one is retired. The table itself is only replaced when it grows or
+// shrinks, which happens when the number of keys doubles or quarters, so that
+// costs O(1) amortized too. Writers must be serialized by the caller.
+template <class Key, class Value, class Hash, template <class T> class Alloc>
+class fresh::event_details::key_index
+{
+public:
+
+    using allocator_type = Alloc<char>;
+
+    explicit key_index(const allocator_type& alloc = allocator_type()) :
+        _allocator(alloc)
+    {
+    }
+
+    key_index(const key_index& other) = delete;
+
+    ~key_index()
+    {
+        if (auto current = _table.load())
+        {
+            current->destroy();
+        }
+    }
+
+    key_index& operator= (const key_index& other) = delete;
+
+    // The value added under key, or a value-initialized one if there's none.
+    Value find(const Key& key) const
+    {
+        auto current = _table.load(std::memory_order_acquire);
+
+        if (!current)
+        {
+            return Value();
+        }
+
+        if (auto keys = current->slot(_hash(key)).load(std::memory_order_acquire))
+        {
+            for (auto& entry : keys->entries)
+            {
+                if (entry.first == key)
+                {
+                    return entry.second;
+                }
+            }
+        }
+
+        return Value();
+    }
+
+    // Adds a key which isn't in the index yet. Returns what's to be retired.
+    retired* insert(const Key& key, Value value)
+    {
+        auto current = _table.load(std::memory_order_relaxed);
+
+        if (!current || _size + 1 > current->slots.size())
+        {
+            auto old = rehash(current ? current->slots.size() * 2 : min_capacity,
+                              &key, value, nullptr);
+            ++_size;
+            return old;
+        }
+
+        auto& slot = current->slot(_hash(key));
+        auto old = slot.load(std::memory_order_relaxed);
+        auto keys = allocate_object<chain>(_allocator, _allocator);
+
+        if (old)
+        {
+            keys->entries.reserve(old->entries.size() + 1);
+            keys->entries = old->entries;
+        }
+
+        keys->entries.emplace_back(key, value);
+        slot.store(keys, std::memory_order_release);
+        ++_size;
+
+        return old;
+    }
+
+    // Removes a key which is in the index. Returns what's to be retired.
+    retired* erase(const Key& key)
+    {
+        auto current = _table.load(std::memory_order_relaxed);
+
+        if (_size == 1)
+        {
+            _size = 0;
+            return _table.exchange(nullptr);
+        }
+
+        if (current->slots.size() > min_capacity && (_size - 1) * 4 < current->slots.size())
+        {
+            auto old = rehash(current->slots.size() / 2, nullptr, Value(), &key);
+            --_size;
+            return old;
+        }
+
+        auto& slot = current->slot(_hash(key));
+        auto old = slot.load(std::memory_order_relaxed);
+        chain* keys = nullptr;
+
+        if (old->entries.size() > 1)
+        {
+            keys = allocate_object<chain>(_allocator, _allocator);
+            keys->entries.reserve(old->entries.size() - 1);
+
+            for (auto& entry : old->entries)
+            {
+                if (!(entry.first == key))
+                {
+                    keys->entries.push_back(entry);
+                }
+            }
+        }
+
+        slot.store(keys, std::memory_order_release);
+        --_size;
+
+        return old;
+    }
+
+private:
+
+    static const size_t min_capacity = 8;
+
+    struct chain : retired
+    {
+        using entry_type = std::pair<Key, Value>;
+
+        chain(const allocator_type& alloc) :
+            entries(alloc)
+        {
+        }
+
+        void destroy() override
+        {
+            destroy_object(entries.get_allocator(), this);
+        }
+
+        std::vector<entry_type, Alloc<entry_type>> entries;
+    };
+
+    // capacity must be a power of two.
+    struct table : retired
+    {
+        table(const allocator_type& alloc, size_t capacity) :
+            slots(capacity, alloc)
+        {
+            for (auto& slot : slots)
+            {
+                slot.store(nullptr, std::memory_order_relaxed);
+            }
+
+            while ((size_t(1) << (64 - shift)) < capacity)
+            {
+                --shift;
+            }
+        }
+
+        // Fibonacci hashing, so hashes which only differ in their high bits,
+        // such as pointers, still spread across the slots.
+        std::atomic<chain*>& slot(size_t hash)
+        {
+            return slots[(size_t)(((uint64_t)hash * 0x9e3779b97f4a7c15ull) >> shift)];
+        }
+
+        void destroy() override
+        {
+            for (auto& slot : slots)
+            {
+                if (auto keys = slot.load(std::memory_order_relaxed))
+                {
+                    keys->destroy();
+                }
+            }
+
+            destroy_object(slots.get_allocator(), this);
+        }
+
+        std::vector<std::atomic<chain*>, Alloc<std::atomic<chain*>>> slots;
+        unsigned shift = 64;
+    };
+
+    // Replaces the table with one of the given capacity, with added and
+    // without removed, and returns the old one.
+    retired* rehash(size_t capacity, const Key* added, const Value& value, const Key* removed)
+    {
+        auto old = _table.load(std::memory_order_relaxed);
+        auto replacement = allocate_object<table>(_allocator, _allocator, capacity);
+
+        auto add = [&](const Key& key, const Value& v)
+        {
+            auto& slot = replacement->slot(_hash(key));
+            auto keys = slot.load(std::memory_order_relaxed);
+
+            if (!keys)
+            {
+                keys = allocate_object<chain>(_allocator, _allocator);
+                slot.store(keys, std::memory_order_relaxed);
+            }
+
+            keys->entries.emplace_back(key, v);
+        };
+
+        try
+        {
+            if (old)
+            {
+                for (auto& slot : old->slots)
+                {
+                    if (auto keys = slot.load(std::memory_order_relaxed))
+                    {
+                        for (auto& entry : keys->entries)
+                        {
+                            if (!removed || !(entry.first == *removed))
+                            {
+                                add(entry.first, entry.second);
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (added)
+            {
+                add(*added, value);
+            }
+        }
+        catch (...)
+        {
+            replacement->destroy();
+            throw;
+        }
+
+        _table.store(replacement, std::memory_order_release);
+
+        return old;
+    }
+
+    allocator_type          _allocator;
+    Hash                    _hash;
+    std::atomic<table*>     _table {nullptr};
+    size_t                  _size = 0;
+};
+
+#endif
@@ -0,0 +1,104 @@
+//
+// mailbox.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_mailbox_hpp
+#define fresh_event_details_mailbox_hpp
+
+#include "../config.hpp"
+
+#include <atomic>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        template <class T>
+        class mailbox;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// An unbounded, lock-free, multi-producer single-consumer FIFO. Pushing is a
+// single exchange, so producers never wait for each other or for the consumer.
+// Values are kept in a linked list whose first node is always empty.
+template <class T>
+class fresh::event_details::mailbox
+{
+public:
+
+    mailbox() :
+        _head(new node()),
+        _tail(_head.load())
+    {
+    }
+
+    mailbox(const mailbox& other) = delete;
+
+    ~mailbox()
+    {
+        while (_tail)
+        {
+            node* next = _tail->next.load();
+            delete _tail;
+            _tail = next;
+        }
+    }
+
+    mailbox& operator= (const mailbox& other) = delete;
+
+    void push(T value)
+    {
+        node* n = new node();
+        n->value = std::move(value);
+
+        node* previous = _head.exchange(n, std::memory_order_acq_rel);
+        previous->next.store(n, std::memory_order_release);
+    }
+
+    // Only the consumer may call this. A value whose push hasn't finished
+    // linking it in may not be seen yet.
+    bool pop(T& value)
+    {
+        node* next = _tail->next.load(std::memory_order_acquire);
+
+        if (!next)
+        {
+            return false;
+        }
+
+        value = std::move(next->value);
+        next->value = T();
+
+        delete _tail;
+        _tail = next;
+
+        return true;
+    }
+
+    // Only the consumer may call this.
+    bool empty() const
+    {
+        return _tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+
+    struct node
+    {
+        std::atomic<node*>  next {nullptr};
+        T                   value;
+    };
+
+    std::atomic<node*>  _head;
+    node*               _tail;
+};
+
+#endif
@@ -0,0 +1,97 @@
+//
+// packed_args.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_packed_args_hpp
+#define fresh_event_details_packed_args_hpp
+
+#include "../config.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        template <class... Args>
+        struct packed_args;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// How an emission's arguments are laid out when they're copied out of the
+// process, to shared memory or to a file: each one's bytes, one after
+// another.
+template <class... Args>
+struct fresh::event_details::packed_args
+{
+    static_assert(std::conjunction<std::is_trivially_copyable<Args>...>::value,
+        "Packed arguments must be trivially copyable.");
+
+    static const size_t size = (sizeof(Args) + ... + 0);
+
+    static void pack(unsigned char* data, const Args&... args)
+    {
+        size_t offset = 0;
+
+        ((std::memcpy(data + offset, &args, sizeof(Args)), offset += sizeof(Args)), ...);
+    }
+
+    template <class Fn>
+    static void unpack(const unsigned char* data, Fn&& fn)
+    {
+        unpack(data, std::forward<Fn>(fn), std::index_sequence_for<Args...>());
+    }
+
+private:
+
+    template <class T>
+    struct field
+    {
+        field(const unsigned char* data)
+        {
+            std::memcpy(&storage, data, sizeof(T));
+        }
+
+        const T& get() const
+        {
+            return *reinterpret_cast<const T*>(&storage);
+        }
+
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    template <size_t I>
+    static size_t offset()
+    {
+        size_t sizes[] = { sizeof(Args)..., 0 };
+        size_t result = 0;
+
+        for (size_t i = 0; i < I; i++)
+        {
+            result += sizes[i];
+        }
+
+        return result;
+    }
+
+    template <class Fn, size_t... I>
+    static void unpack(const unsigned char* data, Fn&& fn, std::index_sequence<I...>)
+    {
+        std::tuple<field<Args>...> fields(data + offset<I>()...);
+
+        fn(std::get<I>(fields).get()...);
+    }
+};
+
+#endif
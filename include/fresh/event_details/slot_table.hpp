@@ -0,0 +1,361 @@
+//
+// slot_table.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_slot_table_hpp
+#define fresh_event_details_slot_table_hpp
+
+#include "../config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        struct slot_handle;
+
+        template <class Slot, template <class T> class Alloc>
+        class slot_table;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// Identifies a slot in a slot_table. The generation changes every time the
+// slot is erased, so a handle to an erased slot never finds its successor.
+struct fresh::event_details::slot_handle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    bool operator== (const slot_handle& rhs) const
+    {
+        return index == rhs.index && generation == rhs.generation;
+    }
+
+    bool operator!= (const slot_handle& rhs) const
+    {
+        return !operator==(rhs);
+    }
+
+    bool operator< (const slot_handle& rhs) const
+    {
+        return std::tie(index, generation) < std::tie(rhs.index, rhs.generation);
+    }
+};
+
+// Dense, connection-ordered storage for the slots of an event. Handles map to
+// positions in the dense array through a table of generation-checked indices,
+// so insertion and lookup are O(1) and iteration is a linear scan.
+//
+// Erased slots leave a tombstone which is compacted away later, so erasing is
+// O(1) amortized. While the table is pinned (during a dispatch), slots are
+// neither moved nor destroyed, and new ones are held back until it's unpinned.
+template <class Slot, template <class T> class Alloc>
+class fresh::event_details::slot_table
+{
+public:
+
+    using handle_type = slot_handle;
+
+    class pin
+    {
+    public:
+
+        pin(slot_table& table) :
+            _table(table)
+        {
+            ++_table._pins;
+        }
+
+        pin(const pin& other) = delete;
+
+        ~pin()
+        {
+            if (--_table._pins == 0)
+            {
+                _table.collect();
+            }
+        }
+
+        pin& operator= (const pin& other) = delete;
+
+    private:
+
+        slot_table& _table;
+    };
+
+    slot_table() = default;
+
+    template <class Allocator>
+    explicit slot_table(const Allocator& alloc) :
+        _dense(alloc),
+        _pending(alloc),
+        _indices(alloc)
+    {
+    }
+
+    slot_table(const slot_table& other) = delete;
+
+    slot_table& operator= (const slot_table& other) = delete;
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool pinned() const
+    {
+        return _pins > 0;
+    }
+
+    // The bytes allocated by the table itself, not counting anything the
+    // slots allocate.
+    size_t memory() const
+    {
+        return (_dense.capacity() + _pending.capacity()) * sizeof(dense_entry) +
+            _indices.capacity() * sizeof(index_entry);
+    }
+
+    handle_type insert(Slot slot)
+    {
+        uint32_t index;
+
+        if (_free != npos)
+        {
+            index = _free;
+            _free = _indices[index].position;
+        }
+        else
+        {
+            index = (uint32_t)_indices.size();
+            _indices.push_back({1, npos});
+        }
+
+        auto& entry = _indices[index];
+
+        entry.position = (uint32_t)(_dense.size() + _pending.size());
+
+        if (_pins > 0)
+        {
+            _pending.push_back({std::move(slot), index});
+        }
+        else
+        {
+            _dense.push_back({std::move(slot), index});
+        }
+
+        ++_size;
+
+        return {index, entry.generation};
+    }
+
+    Slot* find(const handle_type& handle)
+    {
+        if (handle.index >= _indices.size() ||
+            _indices[handle.index].generation != handle.generation)
+        {
+            return nullptr;
+        }
+
+        return &at(_indices[handle.index].position).value;
+    }
+
+    bool erase(const handle_type& handle)
+    {
+        if (!find(handle))
+        {
+            return false;
+        }
+
+        auto& index = _indices[handle.index];
+        auto& erased = at(index.position);
+
+        erased.index = npos;
+
+        // Destroying a slot can run code which connects to or disconnects
+        // from the table, so it's destroyed last, once the table is
+        // consistent again.
+        Slot removed;
+
+        if (_pins == 0)
+        {
+            removed = std::move(erased.value);
+        }
+        else
+        {
+            ++_held;
+        }
+
+        if (++index.generation == 0)
+        {
+            index.generation = 1;
+        }
+
+        index.position = _free;
+        _free = handle.index;
+
+        --_size;
+        ++_tombstones;
+
+        collect();
+
+        return true;
+    }
+
+    // Destroys every slot, and invalidates every handle. The table mustn't be
+    // pinned.
+    void clear()
+    {
+        // As for erase, the slots are destroyed once the table is empty.
+        dense_vector_type dense(std::move(_dense));
+        dense_vector_type pending(std::move(_pending));
+
+        _dense.clear();
+        _pending.clear();
+        _indices.clear();
+        _free = npos;
+        _size = 0;
+        _tombstones = 0;
+        _held = 0;
+    }
+
+    // Calls fn on every live slot in connection order, until it returns
+    // false. Slots inserted during the call aren't visited unless the table
+    // isn't pinned.
+    template <class Fn>
+    void for_each(Fn fn)
+    {
+        for (size_t i = 0; i < _dense.size(); ++i)
+        {
+            if (_dense[i].index != npos && !fn(_dense[i].value))
+            {
+                return;
+            }
+        }
+    }
+
+    // Like for_each, but fn is also passed a function which says whether the
+    // slot has been erased since, for callers which call a slot more than
+    // once. The table must be pinned.
+    template <class Fn>
+    void for_each_checked(Fn fn)
+    {
+        for (size_t i = 0; i < _dense.size(); ++i)
+        {
+            auto erased = [this, i]() { return _dense[i].index == npos; };
+
+            if (!erased() && !fn(_dense[i].value, erased))
+            {
+                return;
+            }
+        }
+    }
+
+private:
+
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    struct index_entry
+    {
+        uint32_t generation;
+        uint32_t position;
+    };
+
+    struct dense_entry
+    {
+        Slot        value;
+        uint32_t    index;
+    };
+
+    dense_entry& at(uint32_t position)
+    {
+        return position < _dense.size() ?
+            _dense[position] : _pending[position - _dense.size()];
+    }
+
+    void collect()
+    {
+        if (_pins > 0)
+        {
+            return;
+        }
+
+        for (auto& entry : _pending)
+        {
+            _dense.push_back(std::move(entry));
+        }
+
+        _pending.clear();
+
+        // Slots erased while pinned still hold on to their value, so those
+        // always need compacting. Otherwise, wait until half are tombstones.
+        if (_held == 0 && _tombstones * 2 <= _dense.size())
+        {
+            return;
+        }
+
+        // Slots held back are moved out, and destroyed once the table has been
+        // compacted, as erase does.
+        std::vector<Slot, Alloc<Slot>> held(_dense.get_allocator());
+
+        if (_held > 0)
+        {
+            held.reserve(_tombstones);
+        }
+
+        size_t live = 0;
+
+        for (auto& entry : _dense)
+        {
+            if (entry.index != npos)
+            {
+                if (&_dense[live] != &entry)
+                {
+                    _dense[live] = std::move(entry);
+                }
+
+                _indices[_dense[live].index].position = (uint32_t)live;
+                ++live;
+            }
+            else if (_held > 0)
+            {
+                held.push_back(std::move(entry.value));
+            }
+        }
+
+        _dense.erase(_dense.begin() + live, _dense.end());
+        _tombstones = 0;
+        _held = 0;
+    }
+
+    using index_vector_type = std::vector<index_entry, Alloc<index_entry>>;
+    using dense_vector_type = std::vector<dense_entry, Alloc<dense_entry>>;
+
+    dense_vector_type   _dense;
+    dense_vector_type   _pending;
+    index_vector_type   _indices;
+    uint32_t            _free = npos;
+    size_t              _size = 0;
+    size_t              _tombstones = 0;
+    size_t              _held = 0;
+    unsigned            _pins = 0;
+};
+
+#endif
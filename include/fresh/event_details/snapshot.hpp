@@ -0,0 +1,147 @@
+//
+// snapshot.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_snapshot_hpp
+#define fresh_event_details_snapshot_hpp
+
+#include "allocation.hpp"
+#include "epoch.hpp"
+#include "event_function.hpp"
+#include "../config.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        template <class Fn, template <class T> class Alloc>
+        class snapshot;
+
+        template <class T>
+        class publisher;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// An immutable list of the functions connected to a thread-safe event at a
+// given point in time. Emitters iterate over it without taking any lock. It's
+// allocated with the same allocator as its list.
+template <class Fn, template <class T> class Alloc>
+class fresh::event_details::snapshot : public retired
+{
+public:
+
+    using function_type = event_function<Fn, true>*;
+    using vector_type = std::vector<function_type, Alloc<function_type>>;
+    using const_iterator = typename vector_type::const_iterator;
+
+    snapshot(vector_type fns) :
+        _fns(std::move(fns))
+    {
+    }
+
+    const_iterator begin() const
+    {
+        return _fns.begin();
+    }
+
+    const_iterator end() const
+    {
+        return _fns.end();
+    }
+
+    size_t size() const
+    {
+        return _fns.size();
+    }
+
+    const event_function<Fn, true>& operator[] (size_t index) const
+    {
+        return *_fns[index];
+    }
+
+    void destroy() override
+    {
+        destroy_object(_fns.get_allocator(), this);
+    }
+
+private:
+
+    const vector_type _fns;
+};
+
+// Holds the current value of a copy-on-write pointer. Readers access it
+// without locking or allocating, from within an epoch_guard; writers, which
+// must be serialized by the caller, replace it and then retire the old value.
+template <class T>
+class fresh::event_details::publisher
+{
+public:
+
+    class reader
+    {
+    public:
+
+        reader(publisher& p) :
+            _value(p._current.load(std::memory_order_acquire))
+        {
+        }
+
+        reader(const reader& other) = delete;
+
+        reader& operator= (const reader& other) = delete;
+
+        explicit operator bool() const
+        {
+            return _value != nullptr;
+        }
+
+        const T& operator* () const
+        {
+            return *_value;
+        }
+
+    private:
+
+        epoch_guard _guard;
+        const T*    _value;
+    };
+
+    publisher() = default;
+
+    publisher(const publisher& other) = delete;
+
+    ~publisher()
+    {
+        if (auto current = _current.load())
+        {
+            current->destroy();
+        }
+    }
+
+    publisher& operator= (const publisher& other) = delete;
+
+    // Returns the old value, for the caller to retire. Retiring can destroy
+    // other retired objects, and whatever their slots captured, so it
+    // mustn't be done while holding the lock which serializes writers.
+    T* publish(T* value)
+    {
+        return _current.exchange(value);
+    }
+
+private:
+
+    std::atomic<T*> _current {nullptr};
+};
+
+#endif
@@ -8,32 +8,68 @@
 #ifndef fresh_event_details_source_hpp
 #define fresh_event_details_source_hpp
 
+#include "allocation.hpp"
+#include "epoch.hpp"
 #include "event_function.hpp"
-#include "source_base.hpp"
+#include "../config.hpp"
+
+#include <utility>
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+    
     namespace event_details
     {
-        template<class Impl>
-        class connection_base;
-     
-        template<class Fn, bool ThreadSafe>
-        class source;
+        template <class Fn, class Allocator>
+        class allocated_function;
 
-        template<bool ThreadSafe>
-        class source_base;
+        template<class Fn, bool ThreadSafe, template <class T> class Alloc>
+        class source;
     }
     
     template <class Impl, class ImplBase, class FnType, bool ThreadSafeEvent, template <class S> class Alloc>
     class event_caller;
 
-    template <class Impl, class FnType, bool ThreadSafe, template <class T> class Alloc>
+    template <class Impl, class FnType, bool ThreadSafe, template <class T> class Alloc,
+        class Locking>
     class event_base;
+
+    template <class Impl, class Key, class FnType, bool ThreadSafe,
+        template <class T> class Alloc, class Hash, class Locking>
+    class keyed_event_base;
+    
+    FRESH_END_NAMESPACE
 }
 
-template <class Fn, bool ThreadSafe>
-class fresh::event_details::source : public source_base<ThreadSafe>
+// A thread-safe function allocated with its event's allocator, which it keeps
+// so that it can free itself once it's reclaimed.
+template <class Fn, class Allocator>
+class fresh::event_details::allocated_function : public event_function<Fn, true>
+{
+public:
+
+    allocated_function(delegate<Fn> fn, const Allocator& alloc) :
+        event_function<Fn, true>(std::move(fn)),
+        _alloc(alloc)
+    {
+    }
+
+    void destroy() override
+    {
+        destroy_object(_alloc, this);
+    }
+
+private:
+
+    Allocator _alloc;
+};
+
+// Thread-safe functions can still be seen by emitters iterating over an older
+// snapshot of the event, so they're allocated separately and retired rather
+// than destroyed.
+template <class Fn, bool ThreadSafe, template <class T> class Alloc>
+class fresh::event_details::source
 {
 public:
     
@@ -41,36 +77,112 @@ public:
     {
     }
     
+    source(source&& other) :
+        _fn(other._fn)
+    {
+        other._fn = nullptr;
+    }
+    
     ~source()
     {
-        if (source_base<ThreadSafe>::_connection)
+        retire();
+    }
+    
+    source& operator= (source&& other)
+    {
+        if (this != &other)
         {
-            source_base<ThreadSafe>::_connection->clear();
+            retire();
+            
+            _fn = other._fn;
+            other._fn = nullptr;
         }
+        
+        return *this;
+    }
+    
+    const event_function<Fn, ThreadSafe>& function() const
+    {
+        return *_fn;
     }
     
 private:
-    template <class Impl, class ImplBase, class Fn2, bool ThreadSafeEvent, template <class S> class Alloc>
+    template <class Impl, class ImplBase, class Fn2, bool ThreadSafeEvent, template <class S> class Alloc2>
     friend class fresh::event_caller;
 
-    template <class Impl, class Fn2, bool ThreadSafeEvent, template <class S> class Alloc>
+    template <class Impl, class Fn2, bool ThreadSafeEvent, template <class S> class Alloc2,
+        class Locking>
     friend class fresh::event_base;
+
+    template <class Impl, class Key, class Fn2, bool ThreadSafeEvent,
+        template <class S> class Alloc2, class Hash, class Locking>
+    friend class fresh::keyed_event_base;
     
-    template <bool ThreadSafeCnxn>
-    friend class fresh::connection;
+    using allocated_type = allocated_function<Fn, Alloc<char>>;
+
+    source(delegate<Fn> fn, const Alloc<char>& alloc) :
+        _fn(allocate_object<allocated_type>(alloc, std::move(fn), alloc))
+    {
+    }
     
-    source(std::function<Fn> fn) :
-        _fn(std::make_shared<event_function<Fn, ThreadSafe>>(fn))
+    // Waits for any call to the function on another thread to finish.
+    void clear()
     {
+        _fn->clear();
     }
     
-    source& operator= (source&& other)
+    // Gives up the function, for the caller to retire.
+    retired* release()
+    {
+        auto fn = _fn;
+        _fn = nullptr;
+        return fn;
+    }
+    
+    void retire()
+    {
+        if (_fn)
+        {
+            epoch_domain::instance().retire(_fn);
+        }
+    }
+    
+    event_function<Fn, ThreadSafe>* _fn = nullptr;
+};
+
+template <class Fn, template <class T> class Alloc>
+class fresh::event_details::source<Fn, false, Alloc>
+{
+public:
+    
+    source()
+    {
+    }
+    
+    source(source&& other) = default;
+    
+    source& operator= (source&& other) = default;
+    
+    const event_function<Fn, false>& function() const
+    {
+        return _fn;
+    }
+    
+private:
+    template <class Impl, class Fn2, bool ThreadSafeEvent, template <class S> class Alloc2,
+        class Locking>
+    friend class fresh::event_base;
+
+    template <class Impl, class Key, class Fn2, bool ThreadSafeEvent,
+        template <class S> class Alloc2, class Hash, class Locking>
+    friend class fresh::keyed_event_base;
+    
+    source(delegate<Fn> fn, const Alloc<char>&) :
+        _fn(std::move(fn))
     {
-        _fn = std::move(other._fn);
-        return *this;
     }
     
-    std::shared_ptr<event_function<Fn, ThreadSafe>> _fn;
+    event_function<Fn, false> _fn;
 };
 
 #endif
@@ -0,0 +1,388 @@
+//
+// static_slot_table.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_event_details_static_slot_table_hpp
+#define fresh_event_details_static_slot_table_hpp
+
+#include "epoch.hpp"
+#include "slot_table.hpp"
+#include "../config.hpp"
+#include "../delegate.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace event_details
+    {
+        template <class Fn, size_t Capacity, bool ThreadSafe>
+        class static_slot_table;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// Inline storage for at most Capacity slots. Slots are called in the order of
+// their position in the table, and a disconnected slot's position is reused by
+// the next connection.
+//
+// Slots erased while the table is being iterated keep their function until the
+// iteration ends, and slots inserted meanwhile aren't visited.
+template <class Fn, size_t Capacity>
+class fresh::event_details::static_slot_table<Fn, Capacity, false>
+{
+public:
+
+    using handle_type = slot_handle;
+
+    class slot
+    {
+    private:
+
+        friend static_slot_table;
+
+        enum class state : uint8_t
+        {
+            free,
+            connected,
+            pending,
+            closed
+        };
+
+        delegate<Fn>    _fn;
+        uint32_t        _generation = 1;
+        state           _state = state::free;
+    };
+
+    static_slot_table() = default;
+
+    static_slot_table(const static_slot_table& other) = delete;
+
+    static_slot_table& operator= (const static_slot_table& other) = delete;
+
+    // Returns null if the table is full.
+    slot* insert(delegate<Fn> fn, handle_type& handle)
+    {
+        for (uint32_t i = 0; i < Capacity; i++)
+        {
+            auto& s = _slots[i];
+
+            if (s._state == slot::state::free)
+            {
+                s._fn = std::move(fn);
+
+                if (_iterating > 0)
+                {
+                    s._state = slot::state::pending;
+                    _deferred = true;
+                }
+                else
+                {
+                    s._state = slot::state::connected;
+                }
+
+                handle = {i, s._generation};
+                return &s;
+            }
+        }
+
+        return nullptr;
+    }
+
+    slot* find(const handle_type& handle)
+    {
+        if (handle.index >= Capacity)
+        {
+            return nullptr;
+        }
+
+        auto& s = _slots[handle.index];
+
+        if (s._generation != handle.generation ||
+            (s._state != slot::state::connected && s._state != slot::state::pending))
+        {
+            return nullptr;
+        }
+
+        return &s;
+    }
+
+    bool erase(const handle_type& handle)
+    {
+        auto s = find(handle);
+
+        if (!s)
+        {
+            return false;
+        }
+
+        if (++s->_generation == 0)
+        {
+            s->_generation = 1;
+        }
+
+        if (_iterating > 0)
+        {
+            s->_state = slot::state::closed;
+            _deferred = true;
+        }
+        else
+        {
+            // Destroying the function can run code which uses the event, or
+            // destroys it, so that's done last.
+            auto removed = std::move(s->_fn);
+            s->_state = slot::state::free;
+        }
+
+        return true;
+    }
+
+    // Calls fn on the function of every connected slot, until it returns
+    // false.
+    template <class F>
+    void for_each(F&& fn)
+    {
+        iteration scope(*this);
+
+        for (size_t i = 0; i < Capacity; i++)
+        {
+            auto& s = _slots[i];
+
+            if (s._state == slot::state::connected && !fn(s._fn))
+            {
+                return;
+            }
+        }
+    }
+
+private:
+
+    class iteration
+    {
+    public:
+
+        iteration(static_slot_table& table) :
+            _table(table)
+        {
+            ++_table._iterating;
+        }
+
+        iteration(const iteration& other) = delete;
+
+        ~iteration()
+        {
+            if (--_table._iterating == 0 && _table._deferred)
+            {
+                _table.settle();
+            }
+        }
+
+        iteration& operator= (const iteration& other) = delete;
+
+    private:
+
+        static_slot_table& _table;
+    };
+
+    void settle()
+    {
+        for (auto& s : _slots)
+        {
+            if (s._state == slot::state::pending)
+            {
+                s._state = slot::state::connected;
+            }
+            else if (s._state == slot::state::closed)
+            {
+                s._fn = nullptr;
+                s._state = slot::state::free;
+            }
+        }
+
+        _deferred = false;
+    }
+
+    slot        _slots[Capacity];
+    unsigned    _iterating = 0;
+    bool        _deferred = false;
+};
+
+// The thread-safe table is lock-free: each slot's state is claimed with a
+// compare-and-swap, and emitters use a call_guard so that erasing a slot can
+// wait until no other thread is calling it. A slot erased by a thread which is
+// itself calling it can't be reused until that call has returned, so it stays
+// closed until a later insert finds it idle.
+template <class Fn, size_t Capacity>
+class fresh::event_details::static_slot_table<Fn, Capacity, true>
+{
+public:
+
+    using handle_type = slot_handle;
+
+    class slot
+    {
+    private:
+
+        friend static_slot_table;
+
+        enum state : uint8_t
+        {
+            free,
+            claimed,
+            connected,
+            closing,
+            closed
+        };
+
+        delegate<Fn>            _fn;
+        uint32_t                _generation = 1;
+        std::atomic<uint8_t>    _state {free};
+    };
+
+    static_slot_table() = default;
+
+    static_slot_table(const static_slot_table& other) = delete;
+
+    static_slot_table& operator= (const static_slot_table& other) = delete;
+
+    // Returns null if the table is full.
+    slot* insert(delegate<Fn> fn, handle_type& handle)
+    {
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (uint32_t i = 0; i < Capacity; i++)
+            {
+                auto& s = _slots[i];
+
+                if (pass == 0 ? claim(s) : reclaim(s))
+                {
+                    s._fn = std::move(fn);
+                    handle = {i, s._generation};
+
+                    s._state.store(slot::connected, std::memory_order_release);
+                    return &s;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    slot* find(const handle_type& handle)
+    {
+        if (handle.index >= Capacity)
+        {
+            return nullptr;
+        }
+
+        auto& s = _slots[handle.index];
+
+        if (s._generation != handle.generation ||
+            s._state.load() != slot::connected)
+        {
+            return nullptr;
+        }
+
+        return &s;
+    }
+
+    bool erase(const handle_type& handle)
+    {
+        auto s = find(handle);
+
+        uint8_t expected = slot::connected;
+
+        if (!s || !s->_state.compare_exchange_strong(expected, slot::closing))
+        {
+            return false;
+        }
+
+        if (++s->_generation == 0)
+        {
+            s->_generation = 1;
+        }
+
+        auto& domain = epoch_domain::instance();
+
+        domain.wait_until_not_called(s);
+
+        if (domain.calling(s))
+        {
+            s->_state.store(slot::closed, std::memory_order_release);
+        }
+        else
+        {
+            // As for the non-thread-safe table, the function is destroyed last.
+            auto removed = std::move(s->_fn);
+            s->_state.store(slot::free, std::memory_order_release);
+        }
+
+        return true;
+    }
+
+    template <class F>
+    void for_each(F&& fn)
+    {
+        for (size_t i = 0; i < Capacity; i++)
+        {
+            auto& s = _slots[i];
+
+            if (s._state.load(std::memory_order_relaxed) != slot::connected)
+            {
+                continue;
+            }
+
+            call_guard guard(&s);
+
+            if (s._state.load() == slot::connected && !fn(s._fn))
+            {
+                return;
+            }
+        }
+    }
+
+private:
+
+    static bool claim(slot& s)
+    {
+        uint8_t expected = slot::free;
+
+        return s._state.compare_exchange_strong(expected, slot::claimed);
+    }
+
+    // Takes over a closed slot once no thread is still calling it.
+    static bool reclaim(slot& s)
+    {
+        uint8_t expected = slot::closed;
+
+        if (!s._state.compare_exchange_strong(expected, slot::claimed))
+        {
+            return false;
+        }
+
+        auto& domain = epoch_domain::instance();
+
+        if (domain.calling(&s))
+        {
+            s._state.store(slot::closed);
+            return false;
+        }
+
+        domain.wait_until_not_called(&s);
+
+        return true;
+    }
+
+    slot _slots[Capacity];
+};
+
+#endif
@@ -9,27 +9,47 @@
 #ifndef fresh_event_details_traits_hpp
 #define fresh_event_details_traits_hpp
 
+#include "../config.hpp"
+#include "../locks.hpp"
 #include "../threads.hpp"
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+    
     namespace event_details
     {
-        template <bool ThreadSafe = false>
+        template <bool ThreadSafe = false, class Locking = default_locking>
         struct event_traits
         {
-            using connection_mutex_type = std::mutex;
-            using event_mutex_type      = std::recursive_mutex;
-            using function_mutex_type   = fresh::shared_mutex;
+            using connection_mutex_type = typename Locking::mutex_type;
+            using event_mutex_type      = typename Locking::mutex_type;
         };
         
-        template <>
-        struct event_traits<false>
+        template <class Locking>
+        struct event_traits<false, Locking>
         {
             using connection_mutex_type = fresh::null_mutex;
             using event_mutex_type      = fresh::null_mutex;
-            using function_mutex_type   = fresh::null_mutex;
         };
+        
+        // How an argument declared as T is passed through dispatch: references
+        // as they are, and anything else by const reference, so that it's only
+        // copied for slots that take it by value.
+        template <class T>
+        struct param
+        {
+            using type = const T&;
+        };
+        
+        template <class T>
+        struct param<T&>
+        {
+            using type = T&;
+        };
+        
+        template <class T>
+        using param_type = typename param<T>::type;
     }
 
     template <class... Args>
@@ -77,6 +97,7 @@ namespace fresh
     };
 
     
+    FRESH_END_NAMESPACE
 }
 
 #endif /* traits_h */
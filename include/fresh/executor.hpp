@@ -0,0 +1,143 @@
+//
+// executor.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_executor_hpp
+#define fresh_executor_hpp
+
+#include "config.hpp"
+#include "delegate.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    class executor;
+
+    class thread_pool;
+
+    FRESH_END_NAMESPACE
+}
+
+// Runs tasks on behalf of an async_event. Implement this to dispatch queued
+// emissions on a run loop, a job system, or any other thread you own.
+class fresh::executor
+{
+public:
+
+    using task_type = delegate<void()>;
+
+    virtual ~executor() = default;
+
+    // Must eventually call task exactly once, on any thread. It may be called
+    // from several threads at a time. The task may throw, e.g. if a slot of
+    // the async_event throws.
+    virtual void execute(task_type task) = 0;
+};
+
+// A small fixed-size pool of worker threads sharing a single task queue.
+// Destroying it runs every task that has already been submitted. A task which
+// throws doesn't stop its worker; the exception is discarded.
+class fresh::thread_pool : public executor
+{
+public:
+
+    // A pool shared by every async_event which isn't given an executor. It's
+    // created on first use and never destroyed.
+    static thread_pool& shared()
+    {
+        static thread_pool* pool =
+            new thread_pool(std::max(2u, std::thread::hardware_concurrency() / 2));
+        return *pool;
+    }
+
+    thread_pool(unsigned threads)
+    {
+        _workers.reserve(threads);
+
+        for (unsigned i = 0; i < threads; i++)
+        {
+            _workers.emplace_back([this]() { run(); });
+        }
+    }
+
+    thread_pool(const thread_pool& other) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+
+        _wakeup.notify_all();
+
+        for (auto& worker : _workers)
+        {
+            worker.join();
+        }
+    }
+
+    thread_pool& operator= (const thread_pool& other) = delete;
+
+    void execute(task_type task) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push_back(std::move(task));
+        }
+
+        _wakeup.notify_one();
+    }
+
+private:
+
+    void run()
+    {
+        for (;;)
+        {
+            task_type task;
+
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+
+                _wakeup.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+                if (_tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    std::vector<std::thread>    _workers;
+    std::deque<task_type>       _tasks;
+    std::mutex                  _mutex;
+    std::condition_variable     _wakeup;
+    bool                        _stopping = false;
+};
+
+#endif
@@ -0,0 +1,370 @@
+//
+// instrumentation.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_instrumentation_hpp
+#define fresh_instrumentation_hpp
+
+#include "config.hpp"
+#include "event_details/instrumentation_hooks.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    class event_registry;
+
+    namespace event_details
+    {
+        class instrumented_event;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+class fresh::event_details::instrumented_event
+{
+public:
+
+    virtual ~instrumented_event() = default;
+
+    virtual void report(event_report& out) = 0;
+};
+
+// Every live instrumented event, in the order they were created.
+class fresh::event_registry
+{
+public:
+
+    static event_registry& instance()
+    {
+        // Intentionally leaked, so events can be destroyed during exit.
+        static event_registry* registry = new event_registry();
+        return *registry;
+    }
+
+    // Reports every event. A non-thread-safe event's slots can only be looked
+    // at on the thread which created it, so from any other thread, only its
+    // counts are reported (see event_report::counts_only).
+    std::vector<event_report> reports()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::vector<event_report> result(_events.size());
+
+        for (size_t i = 0; i < _events.size(); i++)
+        {
+            _events[i]->report(result[i]);
+        }
+
+        return result;
+    }
+
+    void dump_json(std::ostream& out)
+    {
+        out << "[";
+
+        bool first = true;
+
+        for (auto& report : reports())
+        {
+            out << (first ? "\n" : ",\n") << "  {\"address\": \"" << report.address
+                << "\", \"name\": \"" << escaped(report.name)
+                << "\", \"signature\": \"" << escaped(report.signature)
+                << "\", \"thread_safe\": " << (report.thread_safe ? "true" : "false")
+                << ", \"subscribers\": " << report.subscribers
+                << ", \"memory\": " << report.memory
+                << ", \"emits\": " << report.emits
+                << ", \"connects\": " << report.connects
+                << ", \"disconnects\": " << report.disconnects
+                << ", \"counts_only\": " << (report.counts_only ? "true" : "false")
+                << ", \"slots\": [";
+
+            for (size_t i = 0; i < report.slots.size(); i++)
+            {
+                auto& slot = report.slots[i];
+
+                out << (i == 0 ? "" : ", ") << "{\"calls\": " << slot.calls
+                    << ", \"histogram_ns\": {";
+
+                bool firstBucket = true;
+
+                for (size_t b = 0; b < slot_report::buckets; b++)
+                {
+                    if (slot.histogram[b] > 0)
+                    {
+                        out << (firstBucket ? "" : ", ") << "\"" << upper_bound(b)
+                            << "\": " << slot.histogram[b];
+                        firstBucket = false;
+                    }
+                }
+
+                out << "}}";
+            }
+
+            out << "]}";
+            first = false;
+        }
+
+        out << (first ? "]\n" : "\n]\n");
+    }
+
+    void dump_text(std::ostream& out)
+    {
+        for (auto& report : reports())
+        {
+            out << (report.name.empty() ? "<unnamed>" : report.name.c_str())
+                << " " << report.signature
+                << (report.thread_safe ? " (thread-safe)" : "")
+                << (report.counts_only ? " (counts only)" : "")
+                << " at " << report.address << "\n"
+                << "  subscribers: " << report.subscribers
+                << ", memory: " << report.memory << " bytes"
+                << ", emits: " << report.emits
+                << ", connects: " << report.connects
+                << ", disconnects: " << report.disconnects << "\n";
+
+            for (size_t i = 0; i < report.slots.size(); i++)
+            {
+                auto& slot = report.slots[i];
+
+                out << "  slot " << i << ": " << slot.calls << " calls";
+
+                for (size_t b = 0; b < slot_report::buckets; b++)
+                {
+                    if (slot.histogram[b] > 0)
+                    {
+                        out << ", <" << upper_bound(b) << "ns: " << slot.histogram[b];
+                    }
+                }
+
+                out << "\n";
+            }
+        }
+    }
+
+private:
+
+    template <class Impl, bool Enabled>
+    friend class event_details::event_instrumentation;
+
+    event_registry() = default;
+
+    void add(event_details::instrumented_event* e)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _events.push_back(e);
+    }
+
+    // Waits for any report in progress, so the event can be destroyed.
+    void remove(event_details::instrumented_event* e)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        for (size_t i = 0; i < _events.size(); i++)
+        {
+            if (_events[i] == e)
+            {
+                _events.erase(_events.begin() + i);
+                break;
+            }
+        }
+    }
+
+    static uint64_t upper_bound(size_t bucket)
+    {
+        return uint64_t(1) << (bucket + 1);
+    }
+
+    static std::string escaped(const std::string& str)
+    {
+        std::string result;
+
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+            {
+                result += '\\';
+            }
+
+            result += c;
+        }
+
+        return result;
+    }
+
+    std::mutex                                          _mutex;
+    std::vector<event_details::instrumented_event*>     _events;
+};
+
+template <>
+class fresh::event_details::slot_instrumentation<true>
+{
+public:
+
+    // Times a call for as long as it exists.
+    class scope
+    {
+    public:
+
+        scope(const slot_instrumentation& slot) :
+            _slot(slot),
+            _start(std::chrono::steady_clock::now())
+        {
+        }
+
+        scope(const scope& other) = delete;
+
+        ~scope()
+        {
+            auto elapsed = std::chrono::steady_clock::now() - _start;
+
+            _slot.record((uint64_t)
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        scope& operator= (const scope& other) = delete;
+
+    private:
+
+        const slot_instrumentation&             _slot;
+        std::chrono::steady_clock::time_point   _start;
+    };
+
+    slot_instrumentation() = default;
+
+    slot_instrumentation(const slot_instrumentation& other)
+    {
+        *this = other;
+    }
+
+    slot_instrumentation& operator= (const slot_instrumentation& other)
+    {
+        _calls.store(other._calls.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+
+        for (size_t b = 0; b < slot_report::buckets; b++)
+        {
+            _histogram[b].store(other._histogram[b].load(std::memory_order_relaxed),
+                                std::memory_order_relaxed);
+        }
+
+        return *this;
+    }
+
+    void report(slot_report& out) const
+    {
+        out.calls = _calls.load(std::memory_order_relaxed);
+
+        for (size_t b = 0; b < slot_report::buckets; b++)
+        {
+            out.histogram[b] = _histogram[b].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+
+    void record(uint64_t ns) const
+    {
+        size_t bucket = 0;
+
+        while (ns > 1 && bucket < slot_report::buckets - 1)
+        {
+            ns >>= 1;
+            ++bucket;
+        }
+
+        _calls.fetch_add(1, std::memory_order_relaxed);
+        _histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    mutable std::atomic<uint64_t> _calls {0};
+    mutable std::atomic<uint64_t> _histogram[slot_report::buckets] = {};
+};
+
+template <class Impl>
+class fresh::event_details::event_instrumentation<Impl, true> :
+    public instrumented_event
+{
+public:
+
+    // Names the event in the event_registry's reports.
+    void set_name(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(_name_mutex);
+        _name = name;
+    }
+
+    void report(event_report& out) override
+    {
+        out.address = (Impl*)this;
+        out.signature = typeid(typename Impl::function_type).name();
+        out.emits = _emits.load(std::memory_order_relaxed);
+        out.connects = _connects.load(std::memory_order_relaxed);
+        out.disconnects = _disconnects.load(std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock(_name_mutex);
+            out.name = _name;
+        }
+
+        ((Impl*)this)->report_slots(out);
+    }
+
+protected:
+
+    void register_event()
+    {
+        event_registry::instance().add(this);
+    }
+
+    bool on_creating_thread() const
+    {
+        return std::this_thread::get_id() == _creator;
+    }
+
+    void unregister_event()
+    {
+        event_registry::instance().remove(this);
+    }
+
+    void on_emit(uint64_t count = 1)
+    {
+        _emits.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void on_connect()
+    {
+        _connects.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void on_disconnect()
+    {
+        _disconnects.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+
+    std::atomic<uint64_t>   _emits {0};
+    std::atomic<uint64_t>   _connects {0};
+    std::atomic<uint64_t>   _disconnects {0};
+    std::mutex              _name_mutex;
+    std::string             _name;
+    std::thread::id         _creator = std::this_thread::get_id();
+};
+
+#endif
@@ -0,0 +1,527 @@
+//
+// keyed_event.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_keyed_event_hpp
+#define fresh_keyed_event_hpp
+
+#include "config.hpp"
+#include "combiners.hpp"
+#include "connection.hpp"
+#include "delegate.hpp"
+#include "event_details/allocation.hpp"
+#include "event_details/event_interface.hpp"
+#include "event_details/key_index.hpp"
+#include "event_details/slot_table.hpp"
+#include "event_details/snapshot.hpp"
+#include "event_details/source.hpp"
+#include "event_details/traits.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    template <class Key, class FnType, bool ThreadSafe = false,
+        template <class T> class Alloc = std::allocator,
+        class Combiner = typename default_combiner<FnType, Alloc>::type,
+        class Hash = std::hash<Key>,
+        class Locking = default_locking>
+    class keyed_event;
+
+    template <class Impl, class Key, class FnType, bool ThreadSafe,
+        template <class T> class Alloc, class Hash, class Locking>
+    class keyed_event_base;
+
+    FRESH_END_NAMESPACE
+}
+
+// An event whose slots are each connected under a key. Emitting with a key
+// only calls the slots connected under it, which are found through a hash
+// index, so it costs as much as an event with just those slots.
+//
+// Slots under the same key are called in the order they were connected. A
+// thread-safe keyed_event emits without locking, as event does: each key's
+// slots are a snapshot, which is only replaced when they change, and keys are
+// looked up in a key_index, which only replaces what it must when a key is
+// added or removed.
+template <class Impl,
+    class Key,
+    bool ThreadSafe,
+    template <class T> class Alloc,
+    class Hash,
+    class Locking,
+    class Result,
+    class... Args>
+class fresh::keyed_event_base<Impl, Key, Result(Args...), ThreadSafe, Alloc, Hash, Locking> :
+    public event_details::event_interface<ThreadSafe>
+{
+public:
+
+    using key_type = Key;
+    using connection_type = connection<ThreadSafe>;
+    using delegate_type = delegate<Result(Args...)>;
+    using allocator_type = Alloc<char>;
+
+    explicit keyed_event_base(const allocator_type& alloc = allocator_type()) :
+        _allocator(alloc),
+        _buckets(alloc),
+        _entries(alloc),
+        _index(alloc)
+    {
+    }
+
+    keyed_event_base(const keyed_event_base& other) = delete;
+
+    ~keyed_event_base()
+    {
+        this->detach();
+
+        for (auto& bucket : _buckets)
+        {
+            event_details::destroy_object(_allocator, bucket.second);
+        }
+
+        // As for event, what was retired must be reclaimed before the
+        // allocator's memory can go.
+        if (ThreadSafe && !std::is_same<allocator_type, std::allocator<char>>::value)
+        {
+            event_details::epoch_domain::instance().synchronize();
+        }
+    }
+
+    keyed_event_base& operator= (const keyed_event_base& other) = delete;
+
+    connection_type connect(const Key& key, delegate_type fn)
+    {
+        handle_type handle;
+        event_details::retired* oldFns;
+        event_details::retired* oldIndex = nullptr;
+
+        {
+            lock_type lock(_mutex);
+
+            auto bucket = _buckets.find(key);
+
+            if (bucket == _buckets.end())
+            {
+                bucket = _buckets.emplace(key,
+                    event_details::allocate_object<bucket_type>(_allocator, _allocator)).first;
+
+                oldIndex = index_insert(key, bucket->second);
+            }
+
+            auto& sources = bucket->second->sources;
+
+            handle = _entries.insert(
+                entry{key, sources.insert(source_type(std::move(fn), _allocator))});
+
+            oldFns = publish(*bucket->second);
+        }
+
+        event_details::retired* unpublished[] = { oldFns, oldIndex };
+        event_details::epoch_domain::instance().retire(unpublished, 2);
+
+        return this->make_connection(handle);
+    }
+
+    template <class Fn,
+        class = typename std::enable_if<
+            !std::is_same<typename std::decay<Fn>::type, delegate_type>::value &&
+            std::is_invocable_r<Result, typename std::decay<Fn>::type&, Args...>::value>::type>
+    connection_type connect(const Key& key, Fn&& fn)
+    {
+        return connect(key,
+            delegate_type(std::allocator_arg, _allocator, std::forward<Fn>(fn)));
+    }
+
+    template <auto Method, class Owner>
+    connection_type connect(const Key& key, Owner& owner)
+    {
+        return connect(key, delegate_type::template bind<Method>(owner));
+    }
+
+    allocator_type get_allocator() const
+    {
+        return _allocator;
+    }
+
+protected:
+
+    template <class CallHandler>
+    void call(CallHandler& forEach, const Key& key, event_details::param_type<Args>... args)
+    {
+        dispatch(forEach, key, std::integral_constant<bool, ThreadSafe>(), args...);
+    }
+
+private:
+
+    using handle_type = event_details::slot_handle;
+    using mutex_type =
+        typename event_details::event_traits<ThreadSafe, Locking>::event_mutex_type;
+    using lock_type = std::lock_guard<mutex_type>;
+    using source_type = event_details::source<Result(Args...), ThreadSafe, Alloc>;
+    using source_table_type = event_details::slot_table<source_type, Alloc>;
+    using snapshot_type = event_details::snapshot<Result(Args...), Alloc>;
+    using publisher_type = event_details::publisher<snapshot_type>;
+
+    // A key's slots, and for a thread-safe event, the snapshot of them that's
+    // emitted to. Once a key has no slots left its bucket is removed, and
+    // retired if the event is thread-safe.
+    struct bucket_type : event_details::retired
+    {
+        bucket_type(const allocator_type& alloc) :
+            sources(alloc),
+            allocator(alloc)
+        {
+        }
+
+        void destroy() override
+        {
+            event_details::destroy_object(allocator, this);
+        }
+
+        source_table_type   sources;
+        publisher_type      snapshot;
+        allocator_type      allocator;
+    };
+
+    using bucket_map_type = std::unordered_map<Key, bucket_type*, Hash, std::equal_to<Key>,
+        Alloc<std::pair<const Key, bucket_type*>>>;
+
+    // What emitters of a thread-safe event look keys up in.
+    using index_type = event_details::key_index<Key, bucket_type*, Hash, Alloc>;
+
+    // Where the slot behind each connection is.
+    struct entry
+    {
+        Key         key;
+        handle_type handle;
+    };
+
+    using entry_table_type = event_details::slot_table<entry, Alloc>;
+
+    template <class CallHandler>
+    void dispatch(CallHandler& forEach,
+                  const Key& key,
+                  std::true_type,
+                  event_details::param_type<Args>... args)
+    {
+        // The bucket is retired once removed from the index, so it's found
+        // and used within the same guard.
+        event_details::epoch_guard guard;
+
+        auto bucket = _index.find(key);
+
+        if (!bucket)
+        {
+            return;
+        }
+
+        typename publisher_type::reader fns(bucket->snapshot);
+
+        if (!fns)
+        {
+            return;
+        }
+
+        for (auto& fn : *fns)
+        {
+            if (!((Impl*)this)->call_function(forEach, *fn, args...))
+            {
+                break;
+            }
+        }
+    }
+
+    template <class CallHandler>
+    void dispatch(CallHandler& forEach,
+                  const Key& key,
+                  std::false_type,
+                  event_details::param_type<Args>... args)
+    {
+        auto found = _buckets.find(key);
+
+        if (found == _buckets.end())
+        {
+            return;
+        }
+
+        // Buckets don't move when the map is changed by a slot, and a pinned
+        // one isn't removed.
+        auto& bucket = *found->second;
+
+        {
+            typename source_table_type::pin pin(bucket.sources);
+
+            bucket.sources.for_each(
+                [&](const source_type& source)
+                {
+                    return ((Impl*)this)->call_function(forEach, source.function(), args...);
+                });
+        }
+
+        // Unpinning may have destroyed slots whose captures disconnected the
+        // rest of the key's slots, and so removed the bucket already.
+        found = _buckets.find(key);
+
+        if (found != _buckets.end() && found->second->sources.empty() &&
+            !found->second->sources.pinned())
+        {
+            remove_bucket(found);
+        }
+    }
+
+    void close(const handle_type& handle) override
+    {
+        close(handle, std::integral_constant<bool, ThreadSafe>());
+    }
+
+    // As for event, nothing from outside the event is run with the mutex held.
+    void close(const handle_type& handle, std::true_type)
+    {
+        source_type removed;
+        event_details::retired* oldFns;
+        event_details::retired* oldIndex = nullptr;
+        bucket_type* emptied = nullptr;
+
+        {
+            lock_type lock(_mutex);
+
+            auto e = _entries.find(handle);
+
+            if (!e)
+            {
+                return;
+            }
+
+            auto bucket = _buckets.find(e->key);
+            auto& sources = bucket->second->sources;
+
+            removed = std::move(*sources.find(e->handle));
+            sources.erase(e->handle);
+            _entries.erase(handle);
+
+            oldFns = publish(*bucket->second);
+
+            if (sources.empty())
+            {
+                oldIndex = index_erase(bucket->first);
+
+                emptied = bucket->second;
+                _buckets.erase(bucket);
+            }
+        }
+
+        removed.clear();
+
+        event_details::retired* unpublished[] =
+            { oldFns, oldIndex, emptied, removed.release() };
+        event_details::epoch_domain::instance().retire(unpublished, 4);
+    }
+
+    // The slot being called may be the one closed, so its bucket is kept
+    // until the emit finishes. Otherwise, the slot is moved out and destroyed
+    // once the event is consistent again, since what it captured may connect
+    // or disconnect.
+    void close(const handle_type& handle, std::false_type)
+    {
+        auto e = _entries.find(handle);
+
+        if (!e)
+        {
+            return;
+        }
+
+        auto bucket = _buckets.find(e->key);
+        auto& sources = bucket->second->sources;
+
+        source_type removed;
+
+        if (!sources.pinned())
+        {
+            removed = std::move(*sources.find(e->handle));
+        }
+
+        sources.erase(e->handle);
+        _entries.erase(handle);
+
+        if (sources.empty() && !sources.pinned())
+        {
+            remove_bucket(bucket);
+        }
+    }
+
+    void remove_bucket(typename bucket_map_type::iterator bucket)
+    {
+        event_details::destroy_object(_allocator, bucket->second);
+        _buckets.erase(bucket);
+    }
+
+    // These must be called with the mutex held, and return what's to be
+    // retired once it's released.
+    event_details::retired* publish(bucket_type& bucket)
+    {
+        return publish(bucket, std::integral_constant<bool, ThreadSafe>());
+    }
+
+    event_details::retired* publish(bucket_type&, std::false_type)
+    {
+        return nullptr;
+    }
+
+    event_details::retired* publish(bucket_type& bucket, std::true_type)
+    {
+        typename snapshot_type::vector_type fns(_allocator);
+        fns.reserve(bucket.sources.size());
+
+        bucket.sources.for_each(
+            [&](const source_type& source)
+            {
+                fns.push_back(source._fn);
+                return true;
+            });
+
+        return bucket.snapshot.publish(fns.empty() ? nullptr :
+            event_details::allocate_object<snapshot_type>(_allocator, std::move(fns)));
+    }
+
+    event_details::retired* index_insert(const Key& key, bucket_type* bucket)
+    {
+        return ThreadSafe ? _index.insert(key, bucket) : nullptr;
+    }
+
+    event_details::retired* index_erase(const Key& key)
+    {
+        return ThreadSafe ? _index.erase(key) : nullptr;
+    }
+
+    allocator_type          _allocator;
+    mutex_type              _mutex;
+    bucket_map_type         _buckets;
+    entry_table_type        _entries;
+    index_type              _index;
+};
+
+template <class Key,
+    bool ThreadSafe,
+    template <class T> class Alloc,
+    class Combiner,
+    class Hash,
+    class Locking,
+    class Result,
+    class... Args>
+class fresh::keyed_event<Key, Result(Args...), ThreadSafe, Alloc, Combiner, Hash, Locking> :
+    public keyed_event_base<
+        keyed_event<Key, Result(Args...), ThreadSafe, Alloc, Combiner, Hash, Locking>,
+        Key, Result(Args...), ThreadSafe, Alloc, Hash, Locking>
+{
+    static_assert(!ThreadSafe ||
+        is_thread_safe_function_type<Result(Args...)>::value,
+        "Thread-safe events require a function type that passes and returns by copy.");
+
+public:
+
+    using base = keyed_event_base<keyed_event, Key, Result(Args...), ThreadSafe, Alloc, Hash,
+        Locking>;
+
+    using combiner_type = Combiner;
+    using result_type = typename Combiner::result_type;
+
+    using base::base;
+
+    result_type operator()(const Key& key, event_details::param_type<Args>... args)
+    {
+        return combine(make_combiner(std::uses_allocator<Combiner,
+                                     typename base::allocator_type>()),
+                       key, args...);
+    }
+
+    // Emits using the given combiner rather than the event's.
+    template <class CombinerType>
+    auto combine(CombinerType&& combiner,
+                 const Key& key,
+                 event_details::param_type<Args>... args) -> decltype(combiner.result())
+    {
+        base::call(combiner, key, args...);
+
+        return combiner.result();
+    }
+
+private:
+
+    friend base;
+
+    Combiner make_combiner(std::true_type) const
+    {
+        return Combiner(this->get_allocator());
+    }
+
+    Combiner make_combiner(std::false_type) const
+    {
+        return Combiner();
+    }
+
+    template <class CombinerType>
+    bool call_function(CombinerType& combiner,
+                       const event_details::event_function<Result(Args...), ThreadSafe>& fn,
+                       event_details::param_type<Args>... args)
+    {
+        return combiner(fn(args...));
+    }
+};
+
+template <class Key,
+    bool ThreadSafe,
+    template <class T> class Alloc,
+    class Combiner,
+    class Hash,
+    class Locking,
+    class... Args>
+class fresh::keyed_event<Key, void(Args...), ThreadSafe, Alloc, Combiner, Hash, Locking> :
+    public keyed_event_base<
+        keyed_event<Key, void(Args...), ThreadSafe, Alloc, Combiner, Hash, Locking>,
+        Key, void(Args...), ThreadSafe, Alloc, Hash, Locking>
+{
+    static_assert(!ThreadSafe ||
+        is_thread_safe_function_type<void(Args...)>::value,
+        "Thread-safe events require a function type that passes and returns by copy.");
+
+public:
+
+    using base = keyed_event_base<keyed_event, Key, void(Args...), ThreadSafe, Alloc, Hash,
+        Locking>;
+
+    using base::base;
+
+    void operator()(const Key& key, event_details::param_type<Args>... args)
+    {
+        std::nullptr_t forEach = nullptr;
+
+        base::call(forEach, key, args...);
+    }
+
+private:
+
+    friend base;
+
+    bool call_function(std::nullptr_t,
+                       const event_details::event_function<void(Args...), ThreadSafe>& fn,
+                       event_details::param_type<Args>... args)
+    {
+        fn(args...);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,614 @@
+//
+// locks.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_locks_hpp
+#define fresh_locks_hpp
+
+#include "config.hpp"
+#include "threads.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#if defined(__linux__)
+
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    class spin_mutex;
+
+    class spin_shared_mutex;
+
+    class futex_mutex;
+
+    class biased_mutex;
+
+    class biased_shared_mutex;
+
+    struct bias_report;
+
+    // How many mutexes have been biased, and how many of those biases have
+    // been revoked, across the process.
+    bias_report bias_statistics();
+
+    // Lock policies choose the mutexes of thread-safe events and properties.
+    // mutex_type guards an event's slots while connecting and disconnecting,
+    // and shared_mutex_type a property's value. Properties read under a
+    // shared lock if shared_mutex_type has one, and an exclusive one if not.
+
+    // What events and properties have always used.
+    struct default_locking
+    {
+        using mutex_type = std::mutex;
+        using shared_mutex_type = fresh::shared_mutex;
+    };
+
+    // Properties use std::shared_mutex, which is lighter than the
+    // std::shared_timed_mutex they use by default.
+    struct shared_mutex_locking
+    {
+        using mutex_type = std::mutex;
+
+#if FRESH_USE_STD_SHARED_MUTEX
+        using shared_mutex_type = std::shared_mutex;
+#else
+        using shared_mutex_type = fresh::shared_mutex;
+#endif
+    };
+
+    // Spin locks, for critical sections only a few instructions long.
+    struct spin_locking;
+
+    // Futex-based mutexes, which never spin in the kernel's place. Properties
+    // are read under an exclusive lock.
+    struct futex_locking;
+
+    // Mutexes which are biased towards the first thread to lock them, for
+    // events and properties which are thread-safe in case, but which in
+    // practice are only ever used by one thread.
+    struct biased_locking;
+
+    namespace event_details
+    {
+        class spin_wait;
+
+        class asymmetric_fence;
+
+        template <class Mutex>
+        class biased_lock;
+
+        struct bias_counters;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// Spins for a while, then yields each time it's called, for a thread waiting
+// on a lock which should be released soon.
+class fresh::event_details::spin_wait
+{
+public:
+
+    static const unsigned spin_limit = 64;
+
+    void operator() ()
+    {
+        if (_spins < spin_limit)
+        {
+            ++_spins;
+            pause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    static void pause()
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+#elif defined(__GNUC__) && defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+private:
+
+    unsigned _spins = 0;
+};
+
+class fresh::spin_mutex
+{
+public:
+
+    spin_mutex()
+    {
+    }
+
+    spin_mutex(const spin_mutex& other) = delete;
+
+    spin_mutex& operator= (const spin_mutex& other) = delete;
+
+    void lock()
+    {
+        for (event_details::spin_wait wait; !try_lock(); wait())
+        {
+        }
+    }
+
+    bool try_lock()
+    {
+        return !_locked.load(std::memory_order_relaxed) &&
+            !_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock()
+    {
+        _locked.store(false, std::memory_order_release);
+    }
+
+private:
+
+    std::atomic<bool> _locked {false};
+};
+
+// A readers-writer spin lock. A waiting writer stops new readers from
+// getting in, so writers aren't starved by a steady stream of readers.
+class fresh::spin_shared_mutex
+{
+public:
+
+    spin_shared_mutex()
+    {
+    }
+
+    spin_shared_mutex(const spin_shared_mutex& other) = delete;
+
+    spin_shared_mutex& operator= (const spin_shared_mutex& other) = delete;
+
+    void lock()
+    {
+        for (event_details::spin_wait wait; !try_lock(); wait())
+        {
+            // Taking the lock clears this, so every waiting writer sets it
+            // again.
+            if (!(_state.load(std::memory_order_relaxed) & writer_waiting))
+            {
+                _state.fetch_or(writer_waiting, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_lock()
+    {
+        uint32_t state = _state.load(std::memory_order_relaxed);
+
+        return (state & ~writer_waiting) == 0 &&
+            _state.compare_exchange_strong(state, writer, std::memory_order_acquire);
+    }
+
+    void unlock()
+    {
+        _state.fetch_and(~writer, std::memory_order_release);
+    }
+
+    void lock_shared()
+    {
+        for (event_details::spin_wait wait; !try_lock_shared(); wait())
+        {
+        }
+    }
+
+    bool try_lock_shared()
+    {
+        uint32_t state = _state.load(std::memory_order_relaxed);
+
+        return (state & (writer | writer_waiting)) == 0 &&
+            _state.compare_exchange_strong(state, state + 1, std::memory_order_acquire);
+    }
+
+    void unlock_shared()
+    {
+        _state.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+
+    static const uint32_t writer = 1u << 31;
+    static const uint32_t writer_waiting = 1u << 30;
+
+    // The number of readers, and the writer flags.
+    std::atomic<uint32_t> _state {0};
+};
+
+// A mutex which takes a single atomic operation to lock and unlock when it
+// isn't contended, spins briefly when it is, and then sleeps on a futex.
+// Elsewhere than Linux, it yields instead of sleeping.
+class fresh::futex_mutex
+{
+public:
+
+    futex_mutex()
+    {
+    }
+
+    futex_mutex(const futex_mutex& other) = delete;
+
+    futex_mutex& operator= (const futex_mutex& other) = delete;
+
+    void lock()
+    {
+        uint32_t state = unlocked;
+
+        if (_state.compare_exchange_strong(state, locked, std::memory_order_acquire))
+        {
+            return;
+        }
+
+        event_details::spin_wait wait;
+
+        for (unsigned i = 0; i < event_details::spin_wait::spin_limit; i++)
+        {
+            wait();
+
+            if (try_lock())
+            {
+                return;
+            }
+        }
+
+        // From here on, the lock is marked contended, so whoever releases it
+        // wakes a waiter.
+        while (_state.exchange(contended, std::memory_order_acquire) != unlocked)
+        {
+            sleep(contended);
+        }
+    }
+
+    bool try_lock()
+    {
+        uint32_t state = unlocked;
+
+        return _state.load(std::memory_order_relaxed) == unlocked &&
+            _state.compare_exchange_strong(state, locked, std::memory_order_acquire);
+    }
+
+    void unlock()
+    {
+        if (_state.exchange(unlocked, std::memory_order_release) == contended)
+        {
+            wake();
+        }
+    }
+
+private:
+
+    enum : uint32_t
+    {
+        unlocked,
+        locked,
+        contended
+    };
+
+#if defined(__linux__)
+
+    void sleep(uint32_t state)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_state), FUTEX_WAIT_PRIVATE,
+                  state, nullptr, nullptr, 0);
+    }
+
+    void wake()
+    {
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_state), FUTEX_WAKE_PRIVATE,
+                  1, nullptr, nullptr, 0);
+    }
+
+#else
+
+    void sleep(uint32_t)
+    {
+        std::this_thread::yield();
+    }
+
+    void wake()
+    {
+    }
+
+#endif
+
+    std::atomic<uint32_t> _state {unlocked};
+};
+
+struct fresh::bias_report
+{
+    uint64_t biased = 0;
+    uint64_t revocations = 0;
+};
+
+struct fresh::event_details::bias_counters
+{
+    static bias_counters& instance()
+    {
+        static bias_counters counters;
+        return counters;
+    }
+
+    std::atomic<uint64_t> biased {0};
+    std::atomic<uint64_t> revocations {0};
+};
+
+inline fresh::bias_report fresh::bias_statistics()
+{
+    auto& counters = event_details::bias_counters::instance();
+
+    bias_report report;
+    report.biased = counters.biased.load(std::memory_order_relaxed);
+    report.revocations = counters.revocations.load(std::memory_order_relaxed);
+
+    return report;
+}
+
+// A fence for Dekker-style handshakes where one side runs far more often than
+// the other. Where the kernel can interrupt every thread of the process with
+// a barrier (Linux's membarrier), the frequent side gets away with a compiler
+// fence, and the rare side pays for the system call. Elsewhere, both sides
+// use a full fence.
+class fresh::event_details::asymmetric_fence
+{
+public:
+
+    static void light()
+    {
+        if (expedited())
+        {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        }
+        else
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    static void heavy()
+    {
+#if defined(__linux__) && defined(SYS_membarrier)
+        if (expedited() &&
+            ::syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0)
+        {
+            return;
+        }
+#endif
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+private:
+
+    static bool expedited()
+    {
+        static const bool registered = register_process();
+        return registered;
+    }
+
+    static bool register_process()
+    {
+#if defined(__linux__) && defined(SYS_membarrier)
+        return ::syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+#else
+        return false;
+#endif
+    }
+};
+
+// Wraps Mutex so that the first thread to lock it becomes its owner, and then
+// locks and unlocks it with plain stores and no atomic read-modify-writes.
+// When another thread first locks it, the bias is revoked: that thread waits
+// for the owner to leave any critical section it's in, and from then on
+// everyone, the owner included, locks Mutex itself. A bias is never
+// reinstated.
+template <class Mutex>
+class fresh::event_details::biased_lock
+{
+public:
+
+    biased_lock()
+    {
+    }
+
+    biased_lock(const biased_lock& other) = delete;
+
+    biased_lock& operator= (const biased_lock& other) = delete;
+
+    void lock()
+    {
+        if (!lock_biased())
+        {
+            _mutex.lock();
+        }
+    }
+
+    void unlock()
+    {
+        if (!unlock_biased())
+        {
+            _mutex.unlock();
+        }
+    }
+
+    // Whether a thread owns the mutex and hasn't had its bias revoked.
+    bool biased() const
+    {
+        uint64_t owner = _owner.load(std::memory_order_relaxed);
+        return owner != no_owner && owner != revoking_owner && owner != revoked_owner;
+    }
+
+    bool revoked() const
+    {
+        return _owner.load(std::memory_order_acquire) == revoked_owner;
+    }
+
+protected:
+
+    // Returns false if the caller must lock _mutex instead.
+    bool lock_biased()
+    {
+        uint64_t self = thread_id();
+
+        for (spin_wait wait; ; )
+        {
+            uint64_t owner = _owner.load(std::memory_order_acquire);
+
+            if (owner == self)
+            {
+                // Either the revoking thread sees this, and waits for it to
+                // be cleared, or this thread sees that it's being revoked.
+                _held.store(self, std::memory_order_relaxed);
+                asymmetric_fence::light();
+
+                if (_owner.load(std::memory_order_relaxed) == self)
+                {
+                    return true;
+                }
+
+                _held.store(0, std::memory_order_release);
+            }
+            else if (owner == no_owner)
+            {
+                if (_owner.compare_exchange_strong(owner, self))
+                {
+                    bias_counters::instance().biased.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            else if (owner == revoked_owner)
+            {
+                return false;
+            }
+            else if (owner == revoking_owner)
+            {
+                wait();
+            }
+            else if (_owner.compare_exchange_strong(owner, revoking_owner))
+            {
+                revoke();
+            }
+        }
+    }
+
+    // Returns false if the caller must unlock _mutex instead.
+    bool unlock_biased()
+    {
+        if (_held.load(std::memory_order_relaxed) == thread_id())
+        {
+            _held.store(0, std::memory_order_release);
+            return true;
+        }
+
+        return false;
+    }
+
+    Mutex _mutex;
+
+private:
+
+    enum : uint64_t
+    {
+        no_owner = 0,
+        revoking_owner = UINT64_MAX - 1,
+        revoked_owner = UINT64_MAX
+    };
+
+    // Unique for the life of the process, unlike thread ids, which are
+    // reused.
+    static uint64_t thread_id()
+    {
+        static std::atomic<uint64_t> next {1};
+        thread_local uint64_t id = next.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    void revoke()
+    {
+        asymmetric_fence::heavy();
+
+        for (spin_wait wait; _held.load(std::memory_order_acquire) != 0; wait())
+        {
+        }
+
+        _owner.store(revoked_owner, std::memory_order_release);
+
+        bias_counters::instance().revocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The owning thread's id, or one of the states above. Only the owner
+    // writes _held, which is its id while it holds the lock on the fast path.
+    std::atomic<uint64_t> _owner {no_owner};
+    std::atomic<uint64_t> _held {0};
+};
+
+class fresh::biased_mutex : public event_details::biased_lock<std::mutex>
+{
+};
+
+// Once revoked, readers share fresh::shared_mutex. While biased, the owner
+// reads with the same fast path as it writes.
+class fresh::biased_shared_mutex : public event_details::biased_lock<fresh::shared_mutex>
+{
+public:
+
+#if FRESH_USE_STD_SHARED_MUTEX
+
+    void lock_shared()
+    {
+        if (!lock_biased())
+        {
+            _mutex.lock_shared();
+        }
+    }
+
+    void unlock_shared()
+    {
+        if (!unlock_biased())
+        {
+            _mutex.unlock_shared();
+        }
+    }
+
+#endif
+};
+
+struct fresh::spin_locking
+{
+    using mutex_type = spin_mutex;
+    using shared_mutex_type = spin_shared_mutex;
+};
+
+struct fresh::futex_locking
+{
+    using mutex_type = futex_mutex;
+    using shared_mutex_type = futex_mutex;
+};
+
+struct fresh::biased_locking
+{
+    using mutex_type = biased_mutex;
+    using shared_mutex_type = biased_shared_mutex;
+};
+
+#endif
@@ -0,0 +1,42 @@
+//
+// pmr.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_pmr_hpp
+#define fresh_pmr_hpp
+
+#include "config.hpp"
+#include "async_event.hpp"
+#include "event.hpp"
+
+#include <memory_resource>
+
+// Events which allocate everything from a std::pmr::memory_resource, given to
+// their constructors as a std::pmr::polymorphic_allocator. Giving all the
+// events of an object graph the same monotonic_buffer_resource keeps them
+// together, and frees them all at once when the resource is released. The
+// resource must outlive the events.
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    namespace pmr
+    {
+        template <class FnType, bool ThreadSafe = false,
+            class Combiner =
+                typename default_combiner<FnType, std::pmr::polymorphic_allocator>::type>
+        using event = fresh::event<FnType, ThreadSafe, std::pmr::polymorphic_allocator, Combiner>;
+
+        template <class FnType,
+            class Combiner =
+                typename default_combiner<FnType, std::pmr::polymorphic_allocator>::type>
+        using async_event = fresh::async_event<FnType, std::pmr::polymorphic_allocator, Combiner>;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+#endif
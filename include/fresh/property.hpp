@@ -18,6 +18,7 @@
 
 #endif
 
+#include "config.hpp"
 #include "property_details/writable_field.hpp"
 #include "property_details/dynamic_impl.hpp"
 
@@ -25,6 +26,8 @@
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+    
     // signal types
     
     struct null_signal
@@ -35,31 +38,44 @@ namespace fresh
     {
     };
     
-    template <type_policy ReturnTypePolicy, class Event, class Connection, bool ThreadSafe>
+    template <type_policy ReturnTypePolicy, class Event, class Connection, bool ThreadSafe,
+        class Locking = default_locking>
     struct property_attributes
     {
         using connection_type = Connection;
         using event_type = Event;
+        using locking = Locking;
         static const auto return_type_policy = ReturnTypePolicy;
         static const bool thread_safe = ThreadSafe;
     };
     
-    template <type_policy ReturnTypePolicy, bool ThreadSafe>
+    template <type_policy ReturnTypePolicy, bool ThreadSafe, class Locking = default_locking>
     struct basic_observable :
-        public property_attributes<ReturnTypePolicy, event<void(), ThreadSafe>, connection<ThreadSafe>, ThreadSafe>
+        public property_attributes<ReturnTypePolicy,
+            event<void(), ThreadSafe, std::allocator, void, Locking>,
+            connection<ThreadSafe>, ThreadSafe, Locking>
     {
         static_assert(!ThreadSafe || ReturnTypePolicy == copy,
                       "Thread-safe properties must return a copy.");
-        using base = property_attributes<ReturnTypePolicy, event<void(), ThreadSafe>, connection<ThreadSafe>, ThreadSafe>;
+        using base = property_attributes<ReturnTypePolicy,
+            event<void(), ThreadSafe, std::allocator, void, Locking>,
+            connection<ThreadSafe>, ThreadSafe, Locking>;
         
         using connection_type = typename base::connection_type;
         using event_type = typename base::event_type;
         
         template<class... Args>
         static connection_type
-        connect(event_type& sig, Args... args)
+        connect(event_type& sig, Args&&... args)
+        {
+            return sig.connect(std::forward<Args>(args)...);
+        }
+        
+        template<auto Method, class Owner>
+        static connection_type
+        connect(event_type& sig, Owner& owner)
         {
-            return sig.connect(args...);
+            return sig.template connect<Method>(owner);
         }
     };
     
@@ -252,6 +268,8 @@ namespace fresh
         
         friend WriterType;
     };
+    
+    FRESH_END_NAMESPACE
 }
 
 #endif
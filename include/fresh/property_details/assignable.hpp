@@ -9,11 +9,14 @@
 #define fresh_property_details_assignable_hpp
 
 #include "traits.hpp"
+#include "../config.hpp"
 
 #include <cstddef>
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+
     namespace property_details
     {
         template <class T, class Attributes, class Impl>
@@ -264,6 +267,8 @@ namespace fresh
             }
         };
     }
+
+    FRESH_END_NAMESPACE
 }
 
 #endif /* assignable_h */
@@ -10,11 +10,12 @@
 
 #include "signaller.hpp"
 #include "traits.hpp"
-
-#include <vector>
+#include "../config.hpp"
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+
     template <class OwnerType, class Attributes>
     struct dynamic;
     
@@ -45,6 +46,7 @@ namespace fresh
             template<class... Properties>
             dependent_property(Properties&... properties)
             {
+                _propertyConnections.reserve(sizeof...(Properties));
                 connect_to_properties(properties...);
             }
             
@@ -54,13 +56,11 @@ namespace fresh
             void
             connect_to_properties(Property& first, Properties&... rest)
             {
-                auto cnxn = first.connect(
-                    [=]()
+                _propertyConnections.add(first.connect(
+                    [this]()
                     {
                         ((Impl*)this)->send();
-                    });
-                
-                _propertyConnections.push_back(std::move(cnxn));
+                    }));
                 
                 connect_to_properties(rest...);
             }
@@ -70,8 +70,7 @@ namespace fresh
             {
             }
             
-            std::vector<typename Attributes::connection_type>
-                _propertyConnections;
+            connection_group<Attributes::thread_safe> _propertyConnections;
         };
         
         template <class Attributes, class Impl>
@@ -251,6 +250,8 @@ namespace fresh
         };
 #endif
     }
+
+    FRESH_END_NAMESPACE
 }
 
 #endif
@@ -10,10 +10,16 @@
 
 #include "traits.hpp"
 
+#include "../config.hpp"
+#include "../delegate.hpp"
 #include "../event.hpp"
 
+#include <utility>
+
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+
     struct null_signal;
     
     namespace property_details
@@ -33,9 +39,17 @@ namespace fresh
             
             template <class... Args>
             connection_type
-            connect(const std::function<void()>& fn, Args... args)
+            connect(delegate<void()> fn, Args&&... args)
             {
-                return attributes::connect(_onChanged, fn, args...);
+                return attributes::connect(_onChanged, std::move(fn),
+                    std::forward<Args>(args)...);
+            }
+            
+            template <auto Method, class Owner>
+            connection_type
+            connect(Owner& owner)
+            {
+                return attributes::template connect<Method>(_onChanged, owner);
             }
         };
                 
@@ -82,6 +96,8 @@ namespace fresh
         {
         };
     }
+
+    FRESH_END_NAMESPACE
 }
 
 #endif /* signaller_h */
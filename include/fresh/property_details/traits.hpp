@@ -9,11 +9,18 @@
 #ifndef fresh_property_details_traits_hpp
 #define fresh_property_details_traits_hpp
 
+#include "../config.hpp"
+#include "../locks.hpp"
 #include "../threads.hpp"
 #include "../type_policy.hpp"
 
+#include <atomic>
+#include <type_traits>
+
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+
     struct null_signal;
     
     namespace property_details
@@ -40,7 +47,7 @@ namespace fresh
             bool = is_atomic<T, Attributes>::value>
         struct readable_traits
         {
-            using mutex_type = fresh::shared_mutex;
+            using mutex_type = typename Attributes::locking::shared_mutex_type;
             using value_type = T;
         };
         
@@ -149,6 +156,8 @@ namespace fresh
                 has_subtract<T>::value;
         };
     }
+
+    FRESH_END_NAMESPACE
 }
 
 #endif
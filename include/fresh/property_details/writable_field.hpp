@@ -11,12 +11,16 @@
 #include "assignable.hpp"
 #include "signaller.hpp"
 #include "traits.hpp"
+#include "../config.hpp"
+#include "../awaitable.hpp"
 #include "../threads.hpp"
 
 #include <shared_mutex>
 
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+
     template <class Attributes>
     struct has_event;
     
@@ -121,6 +125,19 @@ namespace fresh
             
             using assignable_base::operator=;
             
+#if FRESH_COROUTINES
+            
+            // Queues the value after each change from now on, for a coroutine
+            // to await with co_await changes.next().
+            event_stream<T, Attributes::thread_safe>
+            changes(executor* exec = nullptr)
+            {
+                return event_stream<T, Attributes::thread_safe>(*this,
+                    [this]() { return T((*this)()); }, exec);
+            }
+            
+#endif
+            
         private:
             friend base;
             friend assignable_base;
@@ -170,6 +187,8 @@ namespace fresh
             }
         };
     }
+
+    FRESH_END_NAMESPACE
 }
 
 #endif
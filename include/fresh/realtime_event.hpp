@@ -0,0 +1,131 @@
+//
+// realtime_event.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_realtime_event_hpp
+#define fresh_realtime_event_hpp
+
+#include "config.hpp"
+#include "combiners.hpp"
+#include "event.hpp"
+#include "event_details/epoch.hpp"
+
+#include <memory>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    // Combiners for realtime events mustn't allocate, so non-void ones keep
+    // the last result rather than collecting them.
+    template <class FnType>
+    struct realtime_default_combiner;
+
+    template <class Result, class... Args>
+    struct realtime_default_combiner<Result(Args...)>
+    {
+        using type = last_value<Result>;
+    };
+
+    template <class... Args>
+    struct realtime_default_combiner<void(Args...)>
+    {
+        using type = void;
+    };
+
+    template <class FnType,
+        template <class T> class Alloc = std::allocator,
+        class Combiner = typename realtime_default_combiner<FnType>::type,
+        class Locking = default_locking>
+    class realtime_event;
+
+    FRESH_END_NAMESPACE
+}
+
+// A thread-safe event for emitting from real-time threads, such as audio
+// callbacks, where any lock, allocation or system call risks a missed
+// deadline.
+//
+// Emitting is wait-free and takes time proportional to the number of slots:
+// it reads the published list of slots and calls each in turn, without
+// locking, allocating, or waiting for other threads. Connecting and
+// disconnecting lock and allocate, so they belong on other threads, which
+// also do all of the reclamation; an emit never destroys anything.
+//
+// Each realtime thread must call prepare_thread before it first emits, since
+// a thread's first emit allocates its reclamation state. Emits never use
+// parallel dispatch, and the combiner must not allocate either. Slots run on
+// the realtime thread, so they're bound by the same rules. Neither slots nor
+// the combiner may throw: emitting is noexcept, so an exception escaping
+// either calls std::terminate.
+template <template <class T> class Alloc,
+    class Combiner,
+    class Locking,
+    class Result,
+    class... Args>
+class fresh::realtime_event<Result(Args...), Alloc, Combiner, Locking>
+{
+public:
+
+    using event_type = event<Result(Args...), true, Alloc, Combiner, Locking>;
+
+    using allocator_type = typename event_type::allocator_type;
+    using combiner_type = Combiner;
+    using connection_type = typename event_type::connection_type;
+    using function_type = Result(Args...);
+    using result_type = typename combined_result<Combiner>::type;
+
+    // Prepares the calling thread to emit realtime events.
+    static void prepare_thread()
+    {
+        event_details::epoch_domain::instance().record();
+    }
+
+    explicit realtime_event(const allocator_type& alloc = allocator_type()) :
+        _event(alloc)
+    {
+    }
+
+    realtime_event(const realtime_event& other) = delete;
+
+    realtime_event& operator= (const realtime_event& other) = delete;
+
+    // Takes the same arguments as event::connect. Not for realtime threads.
+    template <class... A>
+    connection_type connect(A&&... args)
+    {
+        return _event.connect(std::forward<A>(args)...);
+    }
+
+    template <class It>
+    void connect_many(It first, It last, connection_group<true>& group)
+    {
+        _event.connect_many(first, last, group);
+    }
+
+    template <auto Method, class Owner>
+    connection_type connect(Owner& owner)
+    {
+        return _event.template connect<Method>(owner);
+    }
+
+    result_type operator() (event_details::param_type<Args>... args) noexcept
+    {
+        return _event(args...);
+    }
+
+    allocator_type get_allocator() const
+    {
+        return _event.get_allocator();
+    }
+
+private:
+
+    event_type _event;
+};
+
+#endif
@@ -0,0 +1,228 @@
+//
+// sharded_event.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_sharded_event_hpp
+#define fresh_sharded_event_hpp
+
+#include "config.hpp"
+#include "event.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    template <class FnType,
+        template <class T> class Alloc = std::allocator,
+        class Combiner = typename default_combiner<FnType, Alloc>::type,
+        class Locking = default_locking>
+    class sharded_event;
+
+    namespace event_details
+    {
+        template <class Combiner>
+        class shard_combiner;
+    }
+
+    FRESH_END_NAMESPACE
+}
+
+// Passes results on to the combiner of a sharded emit, remembering whether it
+// asked to stop so that the remaining shards aren't called either.
+template <class Combiner>
+class fresh::event_details::shard_combiner
+{
+public:
+
+    shard_combiner(Combiner& combiner) :
+        _combiner(combiner)
+    {
+    }
+
+    template <class T>
+    bool operator() (T&& value)
+    {
+        _stopped = !_combiner(std::forward<T>(value));
+        return !_stopped;
+    }
+
+    void result()
+    {
+    }
+
+    bool stopped() const
+    {
+        return _stopped;
+    }
+
+private:
+
+    Combiner&   _combiner;
+    bool        _stopped = false;
+};
+
+// A thread-safe event whose slots are spread over several shards, each with
+// its own mutex, for events which many threads connect to and disconnect from
+// all the time. A thread always connects to the same shard, and its
+// connections go straight back to that shard, so threads connecting and
+// disconnecting at once rarely share a lock. Emitting calls each shard's slots
+// in turn, so slots are called in connection order within a shard, but not
+// across shards.
+template <template <class T> class Alloc,
+    class Combiner,
+    class Locking,
+    class Result,
+    class... Args>
+class fresh::sharded_event<Result(Args...), Alloc, Combiner, Locking>
+{
+public:
+
+    using shard_type = event<Result(Args...), true, Alloc, Combiner, Locking>;
+
+    using allocator_type = typename shard_type::allocator_type;
+    using combiner_type = Combiner;
+    using connection_type = typename shard_type::connection_type;
+    using function_type = Result(Args...);
+    using result_type = typename combined_result<Combiner>::type;
+
+    static size_t default_shard_count()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    explicit sharded_event(size_t shards = default_shard_count(),
+                           const allocator_type& alloc = allocator_type()) :
+        _allocator(alloc)
+    {
+        shards = std::max<size_t>(shards, 1);
+        _shards.reserve(shards);
+
+        for (size_t i = 0; i < shards; i++)
+        {
+            _shards.emplace_back(new shard(alloc));
+        }
+    }
+
+    sharded_event(const sharded_event& other) = delete;
+
+    sharded_event& operator= (const sharded_event& other) = delete;
+
+    // Takes the same arguments as event::connect, and connects to the calling
+    // thread's shard.
+    template <class... A>
+    connection_type connect(A&&... args)
+    {
+        return local_shard().connect(std::forward<A>(args)...);
+    }
+
+    template <class It>
+    void connect_many(It first, It last, connection_group<true>& group)
+    {
+        local_shard().connect_many(first, last, group);
+    }
+
+    template <auto Method, class Owner>
+    connection_type connect(Owner& owner)
+    {
+        return local_shard().template connect<Method>(owner);
+    }
+
+    result_type operator() (event_details::param_type<Args>... args)
+    {
+        return emit(std::is_void<Result>(), args...);
+    }
+
+    // Emits using the given combiner rather than the event's.
+    template <class CombinerType>
+    auto combine(CombinerType&& combiner, event_details::param_type<Args>... args)
+        -> decltype(combiner.result())
+    {
+        event_details::shard_combiner<typename std::remove_reference<CombinerType>::type>
+            each(combiner);
+
+        for (auto& s : _shards)
+        {
+            s->event.combine(each, args...);
+
+            if (each.stopped())
+            {
+                break;
+            }
+        }
+
+        return combiner.result();
+    }
+
+    size_t shard_count() const
+    {
+        return _shards.size();
+    }
+
+    allocator_type get_allocator() const
+    {
+        return _allocator;
+    }
+
+private:
+
+    // Shards are kept apart so that their mutexes aren't on the same cache
+    // line.
+    struct alignas(64) shard
+    {
+        shard(const allocator_type& alloc) :
+            event(alloc)
+        {
+        }
+
+        shard_type event;
+    };
+
+    shard_type& local_shard()
+    {
+        static std::atomic<size_t> next {0};
+        thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+
+        return _shards[index % _shards.size()]->event;
+    }
+
+    void emit(std::true_type, event_details::param_type<Args>... args)
+    {
+        for (auto& s : _shards)
+        {
+            s->event(args...);
+        }
+    }
+
+    result_type emit(std::false_type, event_details::param_type<Args>... args)
+    {
+        return combine(make_combiner(std::uses_allocator<Combiner, allocator_type>()),
+                       args...);
+    }
+
+    Combiner make_combiner(std::true_type) const
+    {
+        return Combiner(_allocator);
+    }
+
+    Combiner make_combiner(std::false_type) const
+    {
+        return Combiner();
+    }
+
+    allocator_type                          _allocator;
+    std::vector<std::unique_ptr<shard>>     _shards;
+};
+
+#endif
@@ -0,0 +1,159 @@
+//
+// shared_payload.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_shared_payload_hpp
+#define fresh_shared_payload_hpp
+
+#include "config.hpp"
+#include "event_details/traits.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    template <class T>
+    class shared_payload;
+
+    template <class T, class... A>
+    shared_payload<T> make_shared_payload(A&&... args);
+
+    // Immutable and reference counted, so thread-safe events can pass these
+    // by const reference.
+    template <class T>
+    struct is_pass_by_copy<const shared_payload<T>&>
+    {
+        static const bool value = true;
+    };
+
+    FRESH_END_NAMESPACE
+}
+
+// An immutable value, built once by make_shared_payload, which is shared
+// rather than copied. Thread-safe events declared with a
+// const shared_payload<T>& argument hand every slot the same value, however
+// many there are and whichever threads they're called on. Slots can take the
+// payload itself, or a const T& to its value.
+template <class T>
+class fresh::shared_payload
+{
+public:
+
+    shared_payload()
+    {
+    }
+
+    shared_payload(const shared_payload& other) :
+        _block(other._block)
+    {
+        if (_block)
+        {
+            _block->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    shared_payload(shared_payload&& other) :
+        _block(other._block)
+    {
+        other._block = nullptr;
+    }
+
+    ~shared_payload()
+    {
+        release();
+    }
+
+    shared_payload& operator= (const shared_payload& other)
+    {
+        shared_payload(other).swap(*this);
+        return *this;
+    }
+
+    shared_payload& operator= (shared_payload&& other)
+    {
+        shared_payload(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    explicit operator bool() const
+    {
+        return _block != nullptr;
+    }
+
+    operator const T& () const
+    {
+        return _block->value;
+    }
+
+    const T& operator* () const
+    {
+        return _block->value;
+    }
+
+    const T* operator-> () const
+    {
+        return &_block->value;
+    }
+
+    const T* get() const
+    {
+        return _block ? &_block->value : nullptr;
+    }
+
+    size_t use_count() const
+    {
+        return _block ? _block->references.load(std::memory_order_relaxed) : 0;
+    }
+
+    void swap(shared_payload& other)
+    {
+        std::swap(_block, other._block);
+    }
+
+private:
+
+    template <class U, class... A>
+    friend shared_payload<U> make_shared_payload(A&&... args);
+
+    // The count and the value share one allocation.
+    struct block
+    {
+        template <class... A>
+        block(A&&... args) :
+            value(std::forward<A>(args)...)
+        {
+        }
+
+        std::atomic<size_t> references {1};
+        const T             value;
+    };
+
+    void release()
+    {
+        if (_block && _block->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete _block;
+        }
+
+        _block = nullptr;
+    }
+
+    block* _block = nullptr;
+};
+
+template <class T, class... A>
+fresh::shared_payload<T> fresh::make_shared_payload(A&&... args)
+{
+    shared_payload<T> payload;
+    payload._block = new typename shared_payload<T>::block(std::forward<A>(args)...);
+    return payload;
+}
+
+#endif
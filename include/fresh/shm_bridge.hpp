@@ -0,0 +1,540 @@
+//
+// shm_bridge.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_shm_bridge_hpp
+#define fresh_shm_bridge_hpp
+
+// Forwards events between processes on the same Linux machine, through a ring
+// buffer in shared memory. Only available on Linux, since waiting uses futexes.
+#if defined(__linux__)
+
+#include "config.hpp"
+#include "connection.hpp"
+#include "delegate.hpp"
+#include "event_details/packed_args.hpp"
+#include "event_details/traits.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    class shm_ring;
+
+    template <class FnType, bool ThreadSafe = true>
+    class shm_publisher;
+
+    template <class FnType>
+    class shm_receiver;
+
+    FRESH_END_NAMESPACE
+}
+
+// A broadcast ring of fixed-size records in a shared memory object. Any number
+// of threads, in any number of processes, can write to it, and each reader has
+// its own cursor, so every reader sees every record unless it falls more than
+// capacity records behind, in which case it skips to the oldest one left.
+// Writers never wait for readers.
+//
+// Rings are either named, with shm_open, or anonymous, with memfd_create, and
+// then shared by passing the descriptor to another process, e.g. by fork.
+class fresh::shm_ring
+{
+public:
+
+    // Creates a ring named name (which must start with '/'), replacing any
+    // existing one. It stays until unlink is called, even once unmapped.
+    static shm_ring create(const std::string& name, size_t capacity, size_t record_size)
+    {
+        ::shm_unlink(name.c_str());
+
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+        if (fd < 0)
+        {
+            throw_errno("shm_open");
+        }
+
+        return shm_ring(fd, capacity, record_size);
+    }
+
+    // Creates an unnamed ring, which is freed when every process using it has
+    // closed its descriptor.
+    static shm_ring create_anonymous(size_t capacity, size_t record_size)
+    {
+        int fd = (int)::syscall(SYS_memfd_create, "fresh_shm_ring", 0);
+
+        if (fd < 0)
+        {
+            throw_errno("memfd_create");
+        }
+
+        return shm_ring(fd, capacity, record_size);
+    }
+
+    static shm_ring open(const std::string& name)
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+
+        if (fd < 0)
+        {
+            throw_errno("shm_open");
+        }
+
+        return shm_ring(fd);
+    }
+
+    // Maps the ring with descriptor fd, which the ring then owns.
+    static shm_ring from_fd(int fd)
+    {
+        return shm_ring(fd);
+    }
+
+    static void unlink(const std::string& name)
+    {
+        ::shm_unlink(name.c_str());
+    }
+
+    shm_ring(const shm_ring& other) = delete;
+
+    shm_ring(shm_ring&& other) :
+        _fd(other._fd),
+        _size(other._size),
+        _header(other._header)
+    {
+        other._fd = -1;
+        other._header = nullptr;
+    }
+
+    ~shm_ring()
+    {
+        if (_header)
+        {
+            ::munmap(_header, _size);
+        }
+
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+        }
+    }
+
+    shm_ring& operator= (const shm_ring& other) = delete;
+
+    int fd() const
+    {
+        return _fd;
+    }
+
+    size_t capacity() const
+    {
+        return (size_t)_header->capacity;
+    }
+
+    size_t record_size() const
+    {
+        return _header->record_size;
+    }
+
+    // The sequence number the next record written will have.
+    uint64_t head() const
+    {
+        return _header->head.load(std::memory_order_acquire);
+    }
+
+    // Copies record_size bytes from data into the next record.
+    void write(const void* data)
+    {
+        uint64_t sequence = _header->head.fetch_add(1, std::memory_order_relaxed);
+        auto& r = at(sequence);
+
+        // Only a writer a whole lap ahead could be using the record, and it
+        // will be done with it soon.
+        uint64_t previous = sequence < capacity() ? 0 : sequence - capacity() + 1;
+
+        while (r.sequence.load(std::memory_order_acquire) != previous)
+        {
+            std::this_thread::yield();
+        }
+
+        r.sequence.store(busy, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(r.data, data, record_size());
+
+        r.sequence.store(sequence + 1, std::memory_order_release);
+
+        _header->signal.fetch_add(1, std::memory_order_seq_cst);
+
+        if (_header->waiters.load(std::memory_order_seq_cst) > 0)
+        {
+            futex(&_header->signal, FUTEX_WAKE, std::numeric_limits<int>::max(), nullptr);
+        }
+    }
+
+    enum class read_result
+    {
+        record,
+        empty,
+        lapped
+    };
+
+    // Copies the record numbered cursor into data and advances cursor. If the
+    // record has been overwritten, cursor is moved to the oldest one left.
+    read_result read(uint64_t& cursor, void* data) const
+    {
+        auto& r = at(cursor);
+
+        uint64_t before = r.sequence.load(std::memory_order_acquire);
+
+        if (before == cursor + 1)
+        {
+            std::memcpy(data, r.data, record_size());
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (r.sequence.load(std::memory_order_relaxed) == before)
+            {
+                ++cursor;
+                return read_result::record;
+            }
+        }
+        else if (before == busy ? head() <= cursor + capacity() : before <= cursor)
+        {
+            // Not written yet, or still being written.
+            return read_result::empty;
+        }
+
+        // Overwritten, or being overwritten, by a writer at least a lap ahead.
+        cursor = head() - capacity();
+        return read_result::lapped;
+    }
+
+    // Waits until the record numbered cursor has been written, or until
+    // timeout. Returns false if it timed out.
+    bool wait(uint64_t cursor, std::chrono::nanoseconds timeout) const
+    {
+        uint32_t signal = _header->signal.load(std::memory_order_seq_cst);
+
+        if (available(cursor))
+        {
+            return true;
+        }
+
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+
+        timespec ts;
+        ts.tv_sec = (time_t)seconds.count();
+        ts.tv_nsec = (long)(timeout - seconds).count();
+
+        _header->waiters.fetch_add(1, std::memory_order_seq_cst);
+
+        // Returns early if a record was written since signal was read.
+        futex(&_header->signal, FUTEX_WAIT, (int)signal, &ts);
+
+        _header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+
+        return available(cursor);
+    }
+
+    // Wakes every waiting reader, e.g. so they can see that they should stop.
+    void notify()
+    {
+        _header->signal.fetch_add(1, std::memory_order_seq_cst);
+        futex(&_header->signal, FUTEX_WAKE, std::numeric_limits<int>::max(), nullptr);
+    }
+
+private:
+
+    static const uint64_t magic = 0x676e726873657266;
+    static const uint64_t busy = std::numeric_limits<uint64_t>::max();
+    static const size_t line_size = 64;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+                  "Shared memory atomics must be lock-free to work between processes.");
+
+    struct header
+    {
+        std::atomic<uint64_t>                   magic;
+        uint64_t                                capacity;
+        uint64_t                                record_size;
+        uint64_t                                stride;
+        alignas(line_size) std::atomic<uint64_t> head;
+        alignas(line_size) std::atomic<uint32_t> signal;
+        std::atomic<uint32_t>                   waiters;
+    };
+
+    // sequence is the record's number plus one, 0 if it's never been written,
+    // or busy while it's being written.
+    struct record
+    {
+        std::atomic<uint64_t>   sequence;
+        unsigned char           data[1];
+    };
+
+    static size_t header_size()
+    {
+        return (sizeof(header) + line_size - 1) / line_size * line_size;
+    }
+
+    // Creates a new ring in the empty object fd.
+    shm_ring(int fd, size_t capacity, size_t record_size) :
+        _fd(fd)
+    {
+        if (capacity == 0)
+        {
+            ::close(fd);
+            throw std::invalid_argument("shm_ring capacity must be positive");
+        }
+
+        size_t stride =
+            (offsetof(record, data) + record_size + line_size - 1) / line_size * line_size;
+
+        _size = header_size() + capacity * stride;
+
+        if (::ftruncate(fd, (off_t)_size) != 0)
+        {
+            ::close(fd);
+            throw_errno("ftruncate");
+        }
+
+        map();
+
+        // The object is zero-filled, so every record is unwritten.
+        _header->capacity = capacity;
+        _header->record_size = record_size;
+        _header->stride = stride;
+        _header->magic.store(magic, std::memory_order_release);
+    }
+
+    // Maps an existing ring.
+    shm_ring(int fd) :
+        _fd(fd)
+    {
+        struct stat st;
+
+        if (::fstat(fd, &st) != 0 || (size_t)st.st_size < header_size())
+        {
+            ::close(fd);
+            throw std::runtime_error("not an shm_ring");
+        }
+
+        _size = (size_t)st.st_size;
+
+        map();
+
+        if (_header->magic.load(std::memory_order_acquire) != magic)
+        {
+            ::munmap(_header, _size);
+            ::close(fd);
+            throw std::runtime_error("not an shm_ring");
+        }
+    }
+
+    void map()
+    {
+        void* p = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+
+        if (p == MAP_FAILED)
+        {
+            ::close(_fd);
+            throw_errno("mmap");
+        }
+
+        _header = static_cast<header*>(p);
+    }
+
+    // Whether reading the record numbered cursor wouldn't come up empty.
+    bool available(uint64_t cursor) const
+    {
+        uint64_t sequence = at(cursor).sequence.load(std::memory_order_acquire);
+
+        return sequence != busy && sequence > cursor;
+    }
+
+    record& at(uint64_t sequence) const
+    {
+        return *reinterpret_cast<record*>(reinterpret_cast<unsigned char*>(_header) +
+            header_size() + (size_t)(sequence % capacity()) * _header->stride);
+    }
+
+    static long futex(std::atomic<uint32_t>* word, int op, int value, const timespec* timeout)
+    {
+        return ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout,
+                         nullptr, 0);
+    }
+
+    [[noreturn]] static void throw_errno(const char* what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    int     _fd = -1;
+    size_t  _size = 0;
+    header* _header = nullptr;
+};
+
+// Writes every emission of an event to a ring, for as long as it exists.
+template <bool ThreadSafe, class... Args>
+class fresh::shm_publisher<void(Args...), ThreadSafe>
+{
+public:
+
+    static_assert(is_thread_safe_function_type<void(Args...)>::value,
+        "Bridged events require a function type that passes by copy.");
+
+    using record_type = event_details::packed_args<Args...>;
+
+    template <class Event>
+    shm_publisher(Event& e, shm_ring& ring) :
+        _ring(ring)
+    {
+        if (ring.record_size() != record_type::size)
+        {
+            throw std::invalid_argument("shm_ring record size doesn't match the event");
+        }
+
+        _connection = e.connect(
+            [this](event_details::param_type<Args>... args)
+            {
+                unsigned char data[record_type::size + 1];
+
+                record_type::pack(data, args...);
+                _ring.write(data);
+            });
+    }
+
+    shm_publisher(const shm_publisher& other) = delete;
+
+    shm_publisher& operator= (const shm_publisher& other) = delete;
+
+private:
+
+    shm_ring&                   _ring;
+    connection<ThreadSafe>      _connection;
+};
+
+// Emits an event for each record written to a ring. Records are only read
+// when receive is called, on the calling thread, and each receiver has its
+// own cursor.
+template <class... Args>
+class fresh::shm_receiver<void(Args...)>
+{
+public:
+
+    static_assert(is_thread_safe_function_type<void(Args...)>::value,
+        "Bridged events require a function type that passes by copy.");
+
+    using record_type = event_details::packed_args<Args...>;
+
+    // Starts from the next record written, or from the oldest one still in
+    // the ring if from_oldest is set.
+    template <class Event>
+    shm_receiver(shm_ring& ring, Event& e, bool from_oldest = false) :
+        _ring(ring),
+        _emit([&e](event_details::param_type<Args>... args) { e(args...); })
+    {
+        if (ring.record_size() != record_type::size)
+        {
+            throw std::invalid_argument("shm_ring record size doesn't match the event");
+        }
+
+        uint64_t head = ring.head();
+
+        if (!from_oldest)
+        {
+            _cursor = head;
+        }
+        else if (head > ring.capacity())
+        {
+            _cursor = head - ring.capacity();
+        }
+    }
+
+    shm_receiver(const shm_receiver& other) = delete;
+
+    shm_receiver& operator= (const shm_receiver& other) = delete;
+
+    // Emits every record written so far, then waits up to timeout for more
+    // if there weren't any. Returns the number emitted.
+    size_t receive(std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0))
+    {
+        size_t received = poll();
+
+        if (received == 0 && timeout.count() > 0 && _ring.wait(_cursor, timeout))
+        {
+            received = poll();
+        }
+
+        return received;
+    }
+
+    // The number of records which were overwritten before they were read.
+    uint64_t lost() const
+    {
+        return _lost;
+    }
+
+private:
+
+    size_t poll()
+    {
+        unsigned char data[record_type::size + 1];
+        size_t received = 0;
+
+        for (;;)
+        {
+            uint64_t cursor = _cursor;
+
+            switch (_ring.read(_cursor, data))
+            {
+                case shm_ring::read_result::record:
+
+                    record_type::unpack(data, _emit);
+                    ++received;
+                    break;
+
+                case shm_ring::read_result::lapped:
+
+                    _lost += _cursor - cursor;
+                    break;
+
+                case shm_ring::read_result::empty:
+
+                    return received;
+            }
+        }
+    }
+
+    shm_ring&                   _ring;
+    delegate<void(Args...)>     _emit;
+    uint64_t                    _cursor = 0;
+    uint64_t                    _lost = 0;
+};
+
+#endif
+
+#endif
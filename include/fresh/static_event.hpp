@@ -0,0 +1,212 @@
+//
+// static_event.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_static_event_hpp
+#define fresh_static_event_hpp
+
+#include "config.hpp"
+#include "combiners.hpp"
+#include "connection.hpp"
+#include "delegate.hpp"
+#include "event_details/event_interface.hpp"
+#include "event_details/static_slot_table.hpp"
+#include "event_details/traits.hpp"
+
+#include <cstddef>
+#include <utility>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    template <class FnType>
+    struct static_default_combiner;
+
+    template <class FnType, size_t Capacity, bool ThreadSafe = false,
+        class Combiner = typename static_default_combiner<FnType>::type>
+    class static_event;
+
+    template <class Impl, class FnType, size_t Capacity, bool ThreadSafe>
+    class static_event_base;
+
+    FRESH_END_NAMESPACE
+}
+
+// collect would allocate, so non-void static events keep the last result by
+// default.
+template <class Result, class... Args>
+struct fresh::static_default_combiner<Result(Args...)>
+{
+    using type = last_value<Result>;
+};
+
+template <class... Args>
+struct fresh::static_default_combiner<void(Args...)>
+{
+    using type = void;
+};
+
+// An event with room for at most Capacity slots, all stored inline. Neither it
+// nor its slots' delegates allocate, as long as the slots fit in
+// delegate::inline_size and no more than 1024 events exist at once (see
+// event_core_table), and the thread-safe variant doesn't lock. Connecting to
+// a full static_event returns a connection to nothing.
+//
+// Slots are called in the order of their position in the event; a position
+// freed by a disconnection is reused by the next connection.
+template <class Impl,
+    size_t Capacity,
+    bool ThreadSafe,
+    class Result,
+    class... Args>
+class fresh::static_event_base<Impl, Result(Args...), Capacity, ThreadSafe> :
+    public event_details::event_interface<ThreadSafe>
+{
+public:
+
+    using connection_type = connection<ThreadSafe>;
+    using delegate_type = delegate<Result(Args...)>;
+
+    static const size_t capacity = Capacity;
+
+    static_event_base() = default;
+
+    static_event_base(const static_event_base& other) = delete;
+
+    ~static_event_base()
+    {
+        this->detach();
+    }
+
+    static_event_base& operator= (const static_event_base& other) = delete;
+
+    connection_type connect(delegate_type fn)
+    {
+        handle_type handle;
+
+        if (!_slots.insert(std::move(fn), handle))
+        {
+            return connection_type();
+        }
+
+        return this->make_connection(handle);
+    }
+
+    template <auto Method, class Owner>
+    connection_type connect(Owner& owner)
+    {
+        return connect(delegate_type::template bind<Method>(owner));
+    }
+
+protected:
+
+    template <class CallHandler>
+    void call(CallHandler& forEach, event_details::param_type<Args>... args)
+    {
+        _slots.for_each(
+            [&](const delegate_type& fn)
+            {
+                return ((Impl*)this)->call_function(forEach, fn, args...);
+            });
+    }
+
+private:
+
+    using handle_type = event_details::slot_handle;
+    using slot_table_type =
+        event_details::static_slot_table<Result(Args...), Capacity, ThreadSafe>;
+
+    void close(const handle_type& handle) override
+    {
+        _slots.erase(handle);
+    }
+
+    slot_table_type _slots;
+};
+
+template <size_t Capacity,
+    bool ThreadSafe,
+    class Combiner,
+    class Result,
+    class... Args>
+class fresh::static_event<Result(Args...), Capacity, ThreadSafe, Combiner> :
+    public static_event_base<static_event<Result(Args...), Capacity, ThreadSafe, Combiner>,
+        Result(Args...), Capacity, ThreadSafe>
+{
+    static_assert(!ThreadSafe ||
+        is_thread_safe_function_type<Result(Args...)>::value,
+        "Thread-safe events require a function type that passes and returns by copy.");
+
+public:
+
+    using base = static_event_base<static_event, Result(Args...), Capacity, ThreadSafe>;
+
+    using combiner_type = Combiner;
+    using result_type = typename Combiner::result_type;
+
+    result_type operator()(event_details::param_type<Args>... args)
+    {
+        return combine(Combiner(), args...);
+    }
+
+    // Emits using the given combiner rather than the event's.
+    template <class CombinerType>
+    auto combine(CombinerType&& combiner, event_details::param_type<Args>... args)
+        -> decltype(combiner.result())
+    {
+        base::call(combiner, args...);
+
+        return combiner.result();
+    }
+
+private:
+
+    friend base;
+
+    template <class CombinerType>
+    bool call_function(CombinerType& combiner,
+                       const delegate<Result(Args...)>& fn,
+                       event_details::param_type<Args>... args)
+    {
+        return combiner(fn(args...));
+    }
+};
+
+template <size_t Capacity, bool ThreadSafe, class Combiner, class... Args>
+class fresh::static_event<void(Args...), Capacity, ThreadSafe, Combiner> :
+    public static_event_base<static_event<void(Args...), Capacity, ThreadSafe, Combiner>,
+        void(Args...), Capacity, ThreadSafe>
+{
+    static_assert(!ThreadSafe ||
+        is_thread_safe_function_type<void(Args...)>::value,
+        "Thread-safe events require a function type that passes and returns by copy.");
+
+public:
+
+    using base = static_event_base<static_event, void(Args...), Capacity, ThreadSafe>;
+
+    void operator()(event_details::param_type<Args>... args)
+    {
+        std::nullptr_t forEach = nullptr;
+
+        base::call(forEach, args...);
+    }
+
+private:
+
+    friend base;
+
+    bool call_function(std::nullptr_t,
+                       const delegate<void(Args...)>& fn,
+                       event_details::param_type<Args>... args)
+    {
+        fn(args...);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,109 @@
+//
+// thread_context.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_thread_context_hpp
+#define fresh_thread_context_hpp
+
+#include "config.hpp"
+#include "executor.hpp"
+#include "event_details/mailbox.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    class thread_context;
+
+    FRESH_END_NAMESPACE
+}
+
+// A mailbox of calls for a thread to make, for slots which must be called on
+// the thread that owns them. Connect such a slot with
+// event::connect(fn, context), and each emit, from whichever thread, posts
+// the call here without waiting; the owning thread then makes it when it
+// calls process_pending or wait_and_process.
+//
+// It's also an executor, so an async_event can deliver on a given thread.
+class fresh::thread_context : public executor
+{
+public:
+
+    static const size_t all = std::numeric_limits<size_t>::max();
+
+    thread_context() = default;
+
+    thread_context(const thread_context& other) = delete;
+
+    thread_context& operator= (const thread_context& other) = delete;
+
+    // May be called from any thread. Never blocks, unless the owning thread
+    // is waiting, in which case it's woken.
+    void execute(task_type task) override
+    {
+        _mailbox.push(std::move(task));
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (_waiting.load())
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _wakeup.notify_one();
+        }
+    }
+
+    // Makes up to max of the calls posted so far, in the order they were
+    // posted, and returns how many it made. Must only be called by the owning
+    // thread.
+    size_t process_pending(size_t max = all)
+    {
+        size_t processed = 0;
+        task_type task;
+
+        while (processed < max && _mailbox.pop(task))
+        {
+            task();
+            task = nullptr;
+            ++processed;
+        }
+
+        return processed;
+    }
+
+    // Like process_pending, but first waits up to timeout for a call to be
+    // posted if there aren't any.
+    size_t wait_and_process(std::chrono::nanoseconds timeout, size_t max = all)
+    {
+        if (_mailbox.empty())
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            _waiting.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            _wakeup.wait_for(lock, timeout, [this]() { return !_mailbox.empty(); });
+            _waiting.store(false);
+        }
+
+        return process_pending(max);
+    }
+
+private:
+
+    event_details::mailbox<task_type>   _mailbox;
+    std::atomic<bool>                   _waiting {false};
+    std::mutex                          _mutex;
+    std::condition_variable             _wakeup;
+};
+
+#endif
@@ -8,7 +8,11 @@
 #ifndef fresh_threads_hpp
 #define fresh_threads_hpp
 
+#include "config.hpp"
+
 #include <mutex>
+#include <type_traits>
+#include <utility>
 
 #ifdef __APPLE__
 
@@ -29,18 +33,34 @@
 
 namespace fresh
 {    
+    FRESH_BEGIN_NAMESPACE
+    
     class null_mutex
     {
         
     };
     
     using atomic_mutex = null_mutex;
+    
+    // Whether T can be locked for reading.
+    template <class T, class = void>
+    struct is_shared_lockable : std::false_type
+    {
+    };
+    
+    template <class T>
+    struct is_shared_lockable<T, std::void_t<decltype(std::declval<T&>().lock_shared())>> :
+        std::true_type
+    {
+    };
 
 #if FRESH_USE_STD_SHARED_MUTEX
     using shared_mutex = std::shared_timed_mutex;
     
+    // Mutexes without a shared mode are locked exclusively for reading.
     template <class T>
-    using read_lock = std::shared_lock<T>;
+    using read_lock = typename std::conditional<is_shared_lockable<T>::value,
+        std::shared_lock<T>, std::lock_guard<T>>::type;
 
     template <class T>
     using write_lock = std::unique_lock<T>;
@@ -55,7 +75,8 @@ namespace fresh
     using write_lock = std::lock_guard<T>;
 
 #endif
-
+    
+    FRESH_END_NAMESPACE
 }
 
 namespace std
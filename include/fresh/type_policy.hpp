@@ -9,8 +9,12 @@
 #ifndef fresh_type_policy_h
 #define fresh_type_policy_h
 
+#include "config.hpp"
+
 namespace fresh
 {
+    FRESH_BEGIN_NAMESPACE
+
     enum class type_policy
     {
         copy,
@@ -19,6 +23,8 @@ namespace fresh
 
     const auto copy = type_policy::copy;
     const auto reference = type_policy::reference;
+
+    FRESH_END_NAMESPACE
 }
 
 #endif /* type_policy_h */
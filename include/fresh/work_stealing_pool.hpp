@@ -0,0 +1,338 @@
+//
+// work_stealing_pool.hpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#ifndef fresh_work_stealing_pool_hpp
+#define fresh_work_stealing_pool_hpp
+
+#include "config.hpp"
+#include "executor.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fresh
+{
+    FRESH_BEGIN_NAMESPACE
+
+    class work_stealing_pool;
+
+    FRESH_END_NAMESPACE
+}
+
+// A pool of worker threads, each with its own task deque. Workers take their
+// own tasks newest first and steal other workers' oldest tasks when they run
+// out, so tasks which fork more tasks stay on one core until someone is idle.
+//
+// parallel_for and parallel_reduce split a range in halves until it's down to
+// grain elements, and the calling thread runs tasks while it waits, so they can
+// be nested and called from within the pool.
+class fresh::work_stealing_pool : public executor
+{
+public:
+
+    work_stealing_pool(unsigned threads = std::thread::hardware_concurrency()) :
+        _queues(threads > 0 ? threads : 1)
+    {
+        _workers.reserve(_queues.size());
+
+        for (size_t i = 0; i < _queues.size(); i++)
+        {
+            _workers.emplace_back([this, i]() { run(i); });
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool& other) = delete;
+
+    ~work_stealing_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+
+        _wakeup.notify_all();
+
+        for (auto& worker : _workers)
+        {
+            worker.join();
+        }
+    }
+
+    work_stealing_pool& operator= (const work_stealing_pool& other) = delete;
+
+    size_t size() const
+    {
+        return _workers.size();
+    }
+
+    void execute(task_type task) override
+    {
+        auto& queue = current() == this ?
+            _queues[worker_index()] :
+            _queues[_next.fetch_add(1, std::memory_order_relaxed) % _queues.size()];
+
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        _queued.fetch_add(1);
+
+        if (_sleeping.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _wakeup.notify_one();
+        }
+    }
+
+    // Calls fn(begin, end) on disjoint subranges covering [0, count), and
+    // returns once they have all returned. If any of them throws, the rest are
+    // still called, and the first exception is rethrown once they've all
+    // returned.
+    template <class Fn>
+    void parallel_for(size_t count, size_t grain, const Fn& fn)
+    {
+        unit result;
+
+        parallel_reduce(count, grain, result,
+            [&](size_t begin, size_t end, unit&)
+            {
+                fn(begin, end);
+            });
+    }
+
+    // Like parallel_for, but each subrange is given its own partial result,
+    // made with result.split(). Partial results are combined with merge(), in
+    // the order of their subranges, as soon as both halves of a split are
+    // done. The first subrange is given result itself.
+    template <class Result, class Fn>
+    void parallel_reduce(size_t count, size_t grain, Result& result, const Fn& fn)
+    {
+        reduce_range(0, count, grain > 0 ? grain : 1, result, fn);
+    }
+
+private:
+
+    struct unit
+    {
+        unit split() const
+        {
+            return unit();
+        }
+
+        void merge(unit&&)
+        {
+        }
+    };
+
+    struct alignas(64) task_queue
+    {
+        std::mutex              mutex;
+        std::deque<task_type>   tasks;
+    };
+
+    template <class Result, class Fn>
+    struct frame
+    {
+        work_stealing_pool*     pool;
+        size_t                  begin;
+        size_t                  end;
+        size_t                  grain;
+        Result*                 result;
+        const Fn*               fn;
+        std::exception_ptr      error;
+        std::atomic<bool>       done {false};
+    };
+
+    static work_stealing_pool*& current()
+    {
+        thread_local work_stealing_pool* pool = nullptr;
+        return pool;
+    }
+
+    static size_t& worker_index()
+    {
+        thread_local size_t index = 0;
+        return index;
+    }
+
+    template <class Result, class Fn>
+    void reduce_range(size_t begin, size_t end, size_t grain,
+                      Result& result, const Fn& fn)
+    {
+        if (end - begin <= grain)
+        {
+            fn(begin, end, result);
+            return;
+        }
+
+        size_t middle = begin + (end - begin) / 2;
+
+        Result right = result.split();
+        frame<Result, Fn> forked {this, middle, end, grain, &right, &fn, nullptr};
+
+        execute(
+            [f = &forked]()
+            {
+                try
+                {
+                    f->pool->reduce_range(f->begin, f->end, f->grain, *f->result, *f->fn);
+                }
+                catch (...)
+                {
+                    f->error = std::current_exception();
+                }
+
+                f->done.store(true, std::memory_order_release);
+            });
+
+        std::exception_ptr error;
+
+        try
+        {
+            reduce_range(begin, middle, grain, result, fn);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        // The forked half refers to this frame, so it has to finish before
+        // this returns, whatever else throws in the meantime.
+        while (!forked.done.load(std::memory_order_acquire))
+        {
+            try
+            {
+                if (!run_one(current() == this ? worker_index() : 0))
+                {
+                    std::this_thread::yield();
+                }
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (!error)
+        {
+            error = forked.error;
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        result.merge(std::move(right));
+    }
+
+    bool take(size_t index, bool newest, task_type& task)
+    {
+        auto& queue = _queues[index];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty())
+        {
+            return false;
+        }
+
+        if (newest)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+
+        _queued.fetch_sub(1);
+
+        return true;
+    }
+
+    // Runs a task from queue index, or steals one from another queue.
+    bool run_one(size_t index)
+    {
+        task_type task;
+
+        if (!take(index, current() == this, task))
+        {
+            size_t count = _queues.size();
+            size_t i = 1;
+
+            for (; i < count && !take((index + i) % count, false, task); i++)
+            {
+            }
+
+            if (i == count)
+            {
+                return false;
+            }
+        }
+
+        task();
+
+        return true;
+    }
+
+    void run(size_t index)
+    {
+        current() = this;
+        worker_index() = index;
+
+        for (;;)
+        {
+            if (run_one(index))
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            _sleeping.fetch_add(1);
+
+            _wakeup.wait(lock,
+                [this]()
+                {
+                    return _queued.load() > 0 || _stopping;
+                });
+
+            _sleeping.fetch_sub(1);
+
+            if (_stopping && _queued.load() == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    std::vector<task_queue>         _queues;
+    std::vector<std::thread>        _workers;
+    std::atomic<size_t>             _next {0};
+    std::atomic<size_t>             _queued {0};
+    std::atomic<unsigned>           _sleeping {0};
+    std::mutex                      _mutex;
+    std::condition_variable         _wakeup;
+    bool                            _stopping = false;
+};
+
+#endif
@@ -0,0 +1,596 @@
+//
+// benchmark_test.cpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+#include "emission_log.hpp"
+#include "event.hpp"
+#include "keyed_event.hpp"
+#include "locks.hpp"
+#include "property.hpp"
+#include "sharded_event.hpp"
+#include "threads.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const int slot_count = 16;
+    const int emit_count = 20000;
+    const int thread_count = 4;
+
+    // Each emitter accumulates into its own sink, so the slots themselves
+    // don't contend.
+    thread_local unsigned sink = 0;
+
+    void slot(int i)
+    {
+        sink += i;
+    }
+
+    // How thread-safe slots used to be called: each one behind its own
+    // reader lock, so a concurrent disconnect could wait for it.
+    struct locked_slot
+    {
+        std::function<void(int)>        fn;
+        mutable fresh::shared_mutex     mutex;
+    };
+
+    template <class Emit>
+    double ns_per_slot(int threads, Emit emit)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> emitters;
+
+        for (int t = 0; t < threads; t++)
+        {
+            emitters.emplace_back(
+                [&]()
+                {
+                    for (int i = 0; i < emit_count; i++)
+                    {
+                        emit(i);
+                    }
+                });
+        }
+
+        for (auto& emitter : emitters)
+        {
+            emitter.join();
+        }
+
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        return elapsed.count() / ((double)emit_count * slot_count);
+    }
+
+    void per_slot_overhead_benchmark(int threads)
+    {
+        std::vector<locked_slot> locked(slot_count);
+
+        for (auto& s : locked)
+        {
+            s.fn = slot;
+        }
+
+        double before = ns_per_slot(threads,
+            [&](int i)
+            {
+                for (auto& s : locked)
+                {
+                    fresh::read_lock<fresh::shared_mutex> lock(s.mutex);
+                    s.fn(i);
+                }
+            });
+
+        fresh::event<void(int), true> e;
+        std::vector<fresh::connection<true>> cnxns;
+
+        for (int s = 0; s < slot_count; s++)
+        {
+            cnxns.push_back(e.connect(slot));
+        }
+
+        double after = ns_per_slot(threads, [&](int i) { e(i); });
+
+        printf("per-slot overhead, %i thread(s): read lock %.1f ns, epoch %.1f ns\n",
+               threads, before, after);
+    }
+
+    // Roughly a microsecond of work.
+    unsigned busy_slot(unsigned value)
+    {
+        volatile unsigned result = value;
+
+        for (unsigned i = 0; i < 500; i++)
+        {
+            result = result * 31 + i;
+        }
+
+        return result;
+    }
+
+    void parallel_dispatch_benchmark()
+    {
+        const int wide_slot_count = 4096;
+        const unsigned wide_emit_count = 20;
+
+        fresh::event<unsigned(unsigned), true, std::allocator, fresh::sum<unsigned>> e;
+        std::vector<fresh::connection<true>> cnxns;
+
+        for (int s = 0; s < wide_slot_count; s++)
+        {
+            cnxns.push_back(e.connect(busy_slot));
+        }
+
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+        for (unsigned threads = 1; threads <= cores; threads *= 2)
+        {
+            // The emitting thread takes part, so the pool needs one fewer.
+            std::unique_ptr<fresh::work_stealing_pool> pool;
+
+            if (threads > 1)
+            {
+                pool.reset(new fresh::work_stealing_pool(threads - 1));
+            }
+
+            e.set_parallel_dispatch(pool.get());
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (unsigned i = 0; i < wide_emit_count; i++)
+            {
+                e(i);
+            }
+
+            std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            printf("parallel dispatch of %i slots, %u thread(s): %.0f us per emit\n",
+                   wide_slot_count, threads, elapsed.count() / wide_emit_count);
+
+            e.set_parallel_dispatch(nullptr);
+        }
+    }
+
+    void connection_sort_benchmark()
+    {
+        const int connection_count = 10000;
+
+        fresh::event<void(), true> e;
+        std::vector<fresh::connection<true>> cnxns;
+
+        for (int i = 0; i < connection_count; i++)
+        {
+            cnxns.push_back(e.connect([]() {}));
+        }
+
+        // Reverse the order so the sort has work to do.
+        std::reverse(cnxns.begin(), cnxns.end());
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::sort(cnxns.begin(), cnxns.end());
+
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        printf("sorting %i thread-safe connections: %.0f us\n",
+               connection_count, elapsed.count());
+    }
+
+    // Every subscriber cares about one id: filtering in each slot against
+    // looking the id's slots up.
+    void keyed_dispatch_benchmark()
+    {
+        const int id_count = 10000;
+        const int keyed_emit_count = 1000;
+
+        fresh::event<void(int, int), true> filtered;
+        fresh::keyed_event<int, void(int), true> keyed;
+        std::vector<fresh::connection<true>> cnxns;
+
+        for (int id = 0; id < id_count; id++)
+        {
+            cnxns.push_back(filtered.connect(
+                [id](int target, int value)
+                {
+                    if (target == id)
+                    {
+                        slot(value);
+                    }
+                }));
+
+            cnxns.push_back(keyed.connect(id, slot));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < keyed_emit_count; i++)
+        {
+            filtered(i % id_count, i);
+        }
+
+        auto middle = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < keyed_emit_count; i++)
+        {
+            keyed(i % id_count, i);
+        }
+
+        std::chrono::duration<double, std::micro> filteredElapsed = middle - start;
+        std::chrono::duration<double, std::micro> keyedElapsed =
+            std::chrono::steady_clock::now() - middle;
+
+        printf("emitting to 1 of %i ids: filtered %.2f us, keyed %.2f us\n", id_count,
+               filteredElapsed.count() / keyed_emit_count,
+               keyedElapsed.count() / keyed_emit_count);
+    }
+
+    // Adding and removing a key of a thread-safe keyed_event, which should
+    // cost the same however many other keys it has.
+    void keyed_churn_benchmark()
+    {
+        const int churn_count = 2000;
+
+        for (int id_count : {100, 1000, 10000})
+        {
+            fresh::keyed_event<int, void(int), true> keyed;
+            std::vector<fresh::connection<true>> cnxns;
+
+            for (int id = 0; id < id_count; id++)
+            {
+                cnxns.push_back(keyed.connect(id, slot));
+            }
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < churn_count; i++)
+            {
+                keyed.connect(id_count + i, slot);
+            }
+
+            std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            printf("adding and removing a key of %i: %.2f us\n", id_count,
+                   elapsed.count() / churn_count);
+        }
+    }
+
+    // Connecting and disconnecting many slots of a thread-safe event one at
+    // a time republishes its slots each time, while a group does it once.
+    void connection_group_benchmark()
+    {
+        const int connection_count = 5000;
+
+        fresh::event<void(), true> e;
+        std::vector<fresh::delegate<void()>> fns;
+
+        auto start = std::chrono::steady_clock::now();
+
+        {
+            std::vector<fresh::connection<true>> cnxns;
+
+            for (int i = 0; i < connection_count; i++)
+            {
+                cnxns.push_back(e.connect([]() {}));
+            }
+        }
+
+        auto middle = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < connection_count; i++)
+        {
+            fns.push_back([]() {});
+        }
+
+        {
+            fresh::connection_group<true> group;
+
+            e.connect_many(std::make_move_iterator(fns.begin()),
+                           std::make_move_iterator(fns.end()), group);
+        }
+
+        std::chrono::duration<double, std::micro> singleElapsed = middle - start;
+        std::chrono::duration<double, std::micro> groupElapsed =
+            std::chrono::steady_clock::now() - middle;
+
+        printf("connecting and disconnecting %i thread-safe slots: one at a time %.0f us, "
+               "as a group %.0f us\n", connection_count,
+               singleElapsed.count(), groupElapsed.count());
+    }
+
+    // What each item costs a thread-safe event's slots, emitted one at a time
+    // or in batches, to slots taking an item or a whole batch.
+    void batch_benchmark()
+    {
+        const int batch_size = 256;
+
+        fresh::event<void(int), true> e;
+        std::vector<std::tuple<int>> items(batch_size);
+
+        for (int i = 0; i < batch_size; i++)
+        {
+            items[i] = std::make_tuple(i);
+        }
+
+        auto ns_per_item = [&](auto emit)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < emit_count / batch_size; i++)
+            {
+                emit();
+            }
+
+            std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            return elapsed.count() / ((double)(emit_count / batch_size) * batch_size * slot_count);
+        };
+
+        std::vector<fresh::connection<true>> cnxns;
+
+        for (int s = 0; s < slot_count; s++)
+        {
+            cnxns.push_back(e.connect(slot));
+        }
+
+        double singleNs = ns_per_item(
+            [&]()
+            {
+                for (auto& item : items)
+                {
+                    e(std::get<0>(item));
+                }
+            });
+
+        double batchNs = ns_per_item([&]() { e.emit_batch(items); });
+
+        cnxns.clear();
+
+        for (int s = 0; s < slot_count; s++)
+        {
+            cnxns.push_back(e.connect_batch(
+                [](const fresh::event<void(int), true>::batch_type& batch)
+                {
+                    for (auto& item : batch)
+                    {
+                        slot(std::get<0>(item));
+                    }
+                }));
+        }
+
+        double batchSlotNs = ns_per_item([&]() { e.emit_batch(items); });
+
+        printf("per-item overhead: single %.1f ns, batch %.1f ns, batch slots %.1f ns\n",
+               singleNs, batchNs, batchSlotNs);
+    }
+
+    // Threads connecting and disconnecting short-lived slots while another
+    // emits.
+    template <class Event>
+    double churn_us(Event& e, int threadCount)
+    {
+        const int churn_count = 2000;
+
+        std::atomic<bool> stop(false);
+        std::thread emitter([&]() { while (!stop) { e(1); } });
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+
+        for (int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    for (int i = 0; i < churn_count; i++)
+                    {
+                        auto cnxn = e.connect(slot);
+                    }
+                });
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        stop = true;
+        emitter.join();
+
+        return elapsed.count() / (threadCount * churn_count);
+    }
+
+    // How connecting and disconnecting scales with the number of threads
+    // doing it: the time per connection, across all threads, should fall as
+    // threads are added, as long as there are cores for them.
+    void sharded_churn_benchmark()
+    {
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+        printf("connecting and disconnecting (%u hardware threads):\n", cores);
+
+        for (int threads = 1; threads <= (int)std::max(cores, 4u); threads *= 2)
+        {
+            fresh::event<void(int), true> single;
+            fresh::sharded_event<void(int)> sharded(threads);
+
+            // Some long-lived slots, which each connection republishes.
+            std::vector<fresh::connection<true>> cnxns;
+
+            for (int i = 0; i < 64; i++)
+            {
+                cnxns.push_back(single.connect(slot));
+                cnxns.push_back(sharded.connect(slot));
+            }
+
+            double singleUs = churn_us(single, threads);
+            double shardedUs = churn_us(sharded, threads);
+
+            printf("  %i threads: single %.2f us, %zu shards %.2f us per connection\n",
+                   threads, singleUs, sharded.shard_count(), shardedUs);
+        }
+    }
+
+    // Thread-safe events emit without locking, so a lock policy matters when
+    // connecting and disconnecting, and when assigning to properties.
+    template <class Locking>
+    void locking_benchmark(const char* name)
+    {
+        const int op_count = 20000;
+
+        using attributes = fresh::property_attributes<fresh::copy, fresh::null_signal,
+            fresh::null_connection, true, Locking>;
+
+        fresh::event<void(int), true, std::allocator, void, Locking> e;
+        fresh::property<double, fresh::writable<attributes>> value = 0.0;
+
+        auto time_ns = [&](auto op)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            std::vector<std::thread> threads;
+
+            for (int t = 0; t < thread_count; t++)
+            {
+                threads.emplace_back(
+                    [&]()
+                    {
+                        for (int i = 0; i < op_count; i++)
+                        {
+                            op();
+                        }
+                    });
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            return elapsed.count() / ((double)thread_count * op_count);
+        };
+
+        double connectNs = time_ns([&]() { auto cnxn = e.connect(slot); });
+        double assignNs = time_ns([&]() { value += 1.0; });
+        double readNs = time_ns([&]() { sink += (unsigned)value(); });
+
+        printf("%s locking from %i threads: connect %.0f ns, assign %.0f ns, read %.0f ns\n",
+               name, thread_count, connectNs, assignNs, readNs);
+    }
+
+    // Properties which are thread-safe in case, but only ever used by the
+    // thread which made them.
+    template <class Locking>
+    void single_thread_locking_benchmark(const char* name)
+    {
+        const int op_count = 200000;
+
+        using attributes = fresh::property_attributes<fresh::copy, fresh::null_signal,
+            fresh::null_connection, true, Locking>;
+
+        fresh::property<double, fresh::writable<attributes>> value = 0.0;
+
+        auto time_ns = [&](auto op)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < op_count; i++)
+            {
+                op();
+            }
+
+            std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            return elapsed.count() / op_count;
+        };
+
+        double assignNs = time_ns([&]() { value += 1.0; });
+        double readNs = time_ns([&]() { sink += (unsigned)value(); });
+
+        printf("%s locking from 1 thread: assign %.1f ns, read %.1f ns\n",
+               name, assignNs, readNs);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+
+    // What recording adds to each emit of an event with a single slot, while
+    // several threads emit at once.
+    void recording_benchmark()
+    {
+        char path[] = "/tmp/fresh_recording_benchmarkXXXXXX";
+        close(mkstemp(path));
+
+        fresh::event<void(int), true> e;
+        auto cnxn = e.connect(slot);
+
+        // ns_per_slot divides by slot_count, but there's only the one slot.
+        double plainNs = ns_per_slot(thread_count, [&](int i) { e(i); }) * slot_count;
+
+        auto log = fresh::emission_log::create(path, 16 << 20);
+        fresh::emission_recorder<void(int)> recorder(e, log, 1);
+
+        double recordingNs = ns_per_slot(thread_count, [&](int i) { e(i); }) * slot_count;
+
+        printf("emitting from %i threads: %.1f ns, recording %.1f ns (%zu recorded)\n",
+               thread_count, plainNs, recordingNs, log.entries().size());
+
+        unlink(path);
+    }
+
+#endif
+}
+
+void benchmark_test()
+{
+    per_slot_overhead_benchmark(1);
+    per_slot_overhead_benchmark(thread_count);
+    parallel_dispatch_benchmark();
+    connection_sort_benchmark();
+    keyed_dispatch_benchmark();
+    keyed_churn_benchmark();
+    connection_group_benchmark();
+    batch_benchmark();
+    sharded_churn_benchmark();
+    locking_benchmark<fresh::default_locking>("default");
+    locking_benchmark<fresh::shared_mutex_locking>("shared_mutex");
+    locking_benchmark<fresh::spin_locking>("spin");
+    locking_benchmark<fresh::futex_locking>("futex");
+    locking_benchmark<fresh::biased_locking>("biased");
+    single_thread_locking_benchmark<fresh::default_locking>("default");
+    single_thread_locking_benchmark<fresh::biased_locking>("biased");
+#if defined(__unix__) || defined(__APPLE__)
+    recording_benchmark();
+#endif
+}
@@ -5,7 +5,1792 @@
 //  Copyright © 2017 Vincent Tourangeau. All rights reserved.
 //
 
+#include "async_event.hpp"
+#include "awaitable.hpp"
+#include "emission_log.hpp"
 #include "event.hpp"
+#include "keyed_event.hpp"
+#include "locks.hpp"
+#include "pmr.hpp"
+#include "property.hpp"
+#include "realtime_event.hpp"
+#include "shared_payload.hpp"
+#include "sharded_event.hpp"
+#include "shm_bridge.hpp"
+#include "static_event.hpp"
+#include "thread_context.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // How many allocations, and how many locks of an event's mutex, each
+    // thread has made, for checking that realtime emits make none.
+    thread_local size_t thread_allocations = 0;
+    thread_local size_t thread_locks = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++thread_allocations;
+    
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++thread_allocations;
+    
+    return std::malloc(size ? size : 1);
+}
+
+// Kept out of line, or GCC takes the free for a mismatch with operator new.
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    void connection_order_test()
+    {
+        fresh::event<void()> e;
+        
+        std::string order;
+        std::vector<fresh::connection<>> cnxns;
+        
+        for (char c = 'a'; c <= 'e'; c++)
+        {
+            cnxns.push_back(e.connect([&order, c]() { order += c; }));
+        }
+        
+        cnxns.pop_back();
+        
+        auto cnxn = e.connect([&]() { order += 'f'; });
+        
+        e();
+        
+        assert(order == "abcdf");
+    }
+    
+    // Emits from several threads while another connects and disconnects, and
+    // checks that each emit sees the slots as they were at some moment, in
+    // connection order.
+    void snapshot_test()
+    {
+        fresh::event<void(std::vector<int>*), true> e;
+        
+        // Slot 0 stays connected throughout. The others are connected in turn,
+        // each before the previous one is disconnected, so no more than two
+        // consecutive ones are connected at once.
+        auto first = e.connect([](std::vector<int>* seen) { seen->push_back(0); });
+        
+        std::atomic<int> disconnected {0};
+        std::atomic<bool> done {false};
+        
+        std::thread churn(
+            [&]()
+            {
+                fresh::connection<true> previous;
+                
+                for (int i = 1; i <= 2000; i++)
+                {
+                    auto next = e.connect(
+                        [&disconnected, i](std::vector<int>* seen)
+                        {
+                            // Never called once its disconnect has returned.
+                            assert(i > disconnected);
+                            seen->push_back(i);
+                        });
+                    
+                    previous.disconnect();
+                    disconnected = i - 1;
+                    previous = std::move(next);
+                }
+                
+                done = true;
+            });
+        
+        std::vector<std::thread> emitters;
+        
+        for (int t = 0; t < 3; t++)
+        {
+            emitters.emplace_back(
+                [&]()
+                {
+                    std::vector<int> seen;
+                    
+                    for (int n = 0; n < 2000 || !done; n++)
+                    {
+                        seen.clear();
+                        e(&seen);
+                        
+                        // Slot 0 is always called first. A slot disconnected
+                        // during the emit may be skipped, but none is called
+                        // twice, and they're called in connection order.
+                        assert(!seen.empty() && seen.size() <= 3 && seen[0] == 0);
+                        assert(seen.size() < 3 || seen[2] == seen[1] + 1);
+                    }
+                });
+        }
+        
+        churn.join();
+        
+        for (auto& emitter : emitters)
+        {
+            emitter.join();
+        }
+    }
+    
+    struct counter
+    {
+        void add(int value)
+        {
+            total += value;
+        }
+        
+        int total = 0;
+    };
+    
+    void delegate_test()
+    {
+        fresh::event<void(int)> e;
+        counter c;
+        
+        auto cnxn1 = e.connect<&counter::add>(c);
+        
+        // move-only callables can be connected
+        auto cnxn2 = e.connect(
+            [factor = std::make_unique<int>(10), &c](int value)
+            {
+                c.total += *factor * value;
+            });
+        
+        e(2);
+        
+        assert(c.total == 22);
+    }
+    
+    void combiner_test()
+    {
+        fresh::event<int(int), false, std::allocator, fresh::sum<int>> e;
+        int calls = 0;
+        
+        auto cnxn1 = e.connect([&](int value) { calls++; return value; });
+        auto cnxn2 = e.connect([&](int value) { calls++; return value * 2; });
+        auto cnxn3 = e.connect([&](int) { calls++; return 0; });
+        
+        assert(e(3) == 9);
+        assert(e.combine(fresh::last_value<int>(), 3) == 0);
+        assert(e.combine(fresh::first_non_default<int>(), 3) == 3);
+        
+        // any_of stops calling slots as soon as one returns true
+        calls = 0;
+        assert(e.combine(fresh::any_of(), 1));
+        assert(calls == 1);
+        assert(!e.combine(fresh::all_of(), 1));
+        
+        std::vector<int> results;
+        e.combine(fresh::output<std::back_insert_iterator<std::vector<int>>>(
+            std::back_inserter(results)), 1);
+        assert((results == std::vector<int>{1, 2, 0}));
+    }
+    
+    // Runs tasks only when asked to, so tests can fill an async_event's queue.
+    class manual_executor : public fresh::executor
+    {
+    public:
+        
+        void execute(task_type task) override
+        {
+            _tasks.push_back(std::move(task));
+        }
+        
+        size_t run()
+        {
+            size_t count = 0;
+            
+            for (; !_tasks.empty(); count++)
+            {
+                auto task = std::move(_tasks.front());
+                _tasks.pop_front();
+                task();
+            }
+            
+            return count;
+        }
+        
+    private:
+        
+        std::deque<task_type> _tasks;
+    };
+    
+    void async_event_test()
+    {
+        {
+            fresh::thread_pool pool(2);
+            fresh::async_event<void(int)> e(pool, 4, fresh::backpressure::block, 2);
+            
+            std::vector<int> received;
+            auto cnxn = e.connect([&](int i) { received.push_back(i); });
+            
+            for (int i = 0; i < 100; i++)
+            {
+                e.post(i);
+            }
+            
+            e.flush();
+            
+            assert(received.size() == 100);
+            
+            for (int i = 0; i < 100; i++)
+            {
+                assert(received[i] == i);
+            }
+        }
+        
+        {
+            manual_executor exec;
+            fresh::async_event<void(int)> e(exec, 4, fresh::backpressure::drop_oldest, 2);
+            
+            std::vector<int> received;
+            auto cnxn = e.connect([&](int i) { received.push_back(i); });
+            
+            for (int i = 1; i <= 10; i++)
+            {
+                e.post(i);
+            }
+            
+            // Two emissions are delivered per task.
+            assert(exec.run() == 2);
+            assert((received == std::vector<int>{7, 8, 9, 10}));
+            assert(e.dropped() == 6);
+        }
+        
+        {
+            manual_executor exec;
+            fresh::async_event<void(int)> e(exec, 4, fresh::backpressure::coalesce);
+            
+            std::vector<int> received;
+            auto cnxn = e.connect([&](int i) { received.push_back(i); });
+            
+            for (int i = 1; i <= 10; i++)
+            {
+                e.post(i);
+            }
+            
+            exec.run();
+            
+            assert((received == std::vector<int>{1, 2, 3, 4, 10}));
+            assert(e.dropped() == 5);
+        }
+        
+        // A throwing slot's exception reaches the executor, and the emissions
+        // after it are still delivered.
+        {
+            manual_executor exec;
+            fresh::async_event<void(int)> e(exec, 4, fresh::backpressure::block, 4);
+            
+            std::vector<int> received;
+            auto cnxn = e.connect(
+                [&](int i)
+                {
+                    if (i == 2)
+                    {
+                        throw std::runtime_error("slot");
+                    }
+                    
+                    received.push_back(i);
+                });
+            
+            for (int i = 1; i <= 4; i++)
+            {
+                e.post(i);
+            }
+            
+            bool caught = false;
+            
+            try
+            {
+                exec.run();
+            }
+            catch (const std::runtime_error&)
+            {
+                caught = true;
+            }
+            
+            assert(caught);
+            assert(exec.run() == 1);
+            assert((received == std::vector<int>{1, 3, 4}));
+            
+            // Every cell is free again, including the throwing emission's.
+            for (int i = 5; i <= 8; i++)
+            {
+                e.post(i);
+            }
+            
+            exec.run();
+            
+            assert(received.size() == 7 && received.back() == 8);
+        }
+        
+        // A thread_pool's workers carry on after a task throws.
+        {
+            fresh::thread_pool pool(2);
+            fresh::async_event<void(int)> e(pool, 4, fresh::backpressure::block, 2);
+            
+            std::atomic<int> received {0};
+            auto cnxn = e.connect(
+                [&](int i)
+                {
+                    if (i % 10 == 0)
+                    {
+                        throw std::runtime_error("slot");
+                    }
+                    
+                    ++received;
+                });
+            
+            for (int i = 0; i < 100; i++)
+            {
+                e.post(i);
+            }
+            
+            e.flush();
+            
+            assert(received == 90);
+        }
+    }
+    
+    void parallel_dispatch_test()
+    {
+        fresh::work_stealing_pool pool(3);
+        
+        fresh::event<int(int), true> e;
+        std::vector<fresh::connection<true>> cnxns;
+        
+        for (int i = 0; i < 1000; i++)
+        {
+            cnxns.push_back(e.connect([i](int value) { return i * value; }));
+        }
+        
+        e.set_parallel_dispatch(&pool, 100);
+        
+        // Results are collected in connection order, whichever thread
+        // called the slot.
+        auto results = e(2);
+        
+        assert(results.size() == 1000);
+        
+        for (int i = 0; i < 1000; i++)
+        {
+            assert(results[i] == i * 2);
+        }
+        
+        assert(e.combine(fresh::sum<int>(), 1) == 999 * 1000 / 2);
+        assert(e.combine(fresh::last_value<int>(), 1) == 999);
+        
+        std::atomic<int> calls {0};
+        fresh::event<void(), true> v;
+        std::vector<fresh::connection<true>> vcnxns;
+        
+        for (int i = 0; i < 1000; i++)
+        {
+            vcnxns.push_back(v.connect([&]() { calls++; }));
+        }
+        
+        v.set_parallel_dispatch(&pool, 100);
+        v();
+        
+        assert(calls == 1000);
+        
+        // A throwing slot's exception reaches the emitter, once every task
+        // of the emission has finished with it.
+        vcnxns.push_back(v.connect([]() { throw std::runtime_error("slot"); }));
+        
+        for (int i = 0; i < 1000; i++)
+        {
+            vcnxns.push_back(v.connect([&]() { calls++; }));
+        }
+        
+        bool caught = false;
+        
+        try
+        {
+            v();
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+        }
+        
+        assert(caught);
+        
+        cnxns.push_back(e.connect([](int) -> int { throw std::runtime_error("slot"); }));
+        caught = false;
+        
+        try
+        {
+            e.combine(fresh::sum<int>(), 1);
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+        }
+        
+        assert(caught);
+        
+        // The pool is still usable afterwards.
+        cnxns.pop_back();
+        assert(e.combine(fresh::sum<int>(), 1) == 999 * 1000 / 2);
+        
+        vcnxns.erase(vcnxns.begin() + 1000);
+        calls = 0;
+        v();
+        
+        assert(calls == 2000);
+        
+        v.set_parallel_dispatch(nullptr);
+        calls = 0;
+        v();
+        
+        assert(calls == 2000);
+    }
+    
+    void static_event_test()
+    {
+        fresh::static_event<void(int), 2> e;
+        
+        int sum = 0;
+        
+        {
+            auto cnxn1 = e.connect([&](int i) { sum += i; });
+            auto cnxn2 = e.connect([&](int i) { sum += i * 10; });
+            auto cnxn3 = e.connect([&](int i) { sum += i * 100; });
+            
+            // The event only has room for two slots.
+            assert(cnxn1.connected() && cnxn2.connected() && !cnxn3.connected());
+            
+            e(1);
+            assert(sum == 11);
+        }
+        
+        e(1);
+        assert(sum == 11);
+        
+        fresh::static_event<int(), 4, true> ts;
+        std::vector<fresh::connection<true>> cnxns;
+        
+        cnxns.push_back(ts.connect([&]() { cnxns.clear(); return 1; }));
+        cnxns.push_back(ts.connect([]() { return 2; }));
+        
+        // The first slot disconnects both, so the second isn't called.
+        assert(ts() == 1);
+        assert(ts() == 0);
+        
+        // Creating and destroying one doesn't allocate.
+        size_t allocations = thread_allocations;
+        
+        {
+            fresh::static_event<void(int), 2, true> quiet;
+            auto cnxn = quiet.connect([&](int i) { sum += i; });
+            
+            quiet(1);
+        }
+        
+        assert(thread_allocations == allocations && sum == 12);
+    }
+    
+    void connection_handle_test()
+    {
+        static_assert(sizeof(fresh::connection<true>) <= 2 * sizeof(void*),
+                      "Connections should be two words");
+        
+        int calls = 0;
+        std::vector<fresh::connection<true>> cnxns;
+        
+        {
+            fresh::event<void(), true> e;
+            
+            for (int i = 0; i < 4; i++)
+            {
+                cnxns.push_back(e.connect([&]() { calls++; }));
+            }
+            
+            std::sort(cnxns.begin(), cnxns.end());
+            cnxns.erase(cnxns.begin());
+            
+            e();
+            assert(calls == 3);
+            
+            cnxns[0].disconnect();
+            assert(!cnxns[0].connected());
+            
+            e();
+            assert(calls == 5);
+        }
+        
+        // The event is gone, so these no longer disconnect anything.
+        assert(!cnxns[1].connected());
+        cnxns.clear();
+        
+        // Enough events at once to need more than the first block of cores.
+        std::vector<std::unique_ptr<fresh::static_event<void(), 1, true>>> events;
+        
+        for (int i = 0; i < 5000; i++)
+        {
+            events.emplace_back(new fresh::static_event<void(), 1, true>());
+            cnxns.push_back(events.back()->connect([&]() { calls++; }));
+        }
+        
+        calls = 0;
+        
+        for (auto& e : events)
+        {
+            (*e)();
+        }
+        
+        assert(calls == 5000);
+        
+        events.clear();
+        
+        for (auto& cnxn : cnxns)
+        {
+            assert(!cnxn.connected());
+        }
+        
+        cnxns.clear();
+    }
+    
+    // Runs a function when destroyed, for slots whose captures connect or
+    // disconnect when they're reclaimed.
+    struct on_destroy
+    {
+        ~on_destroy()
+        {
+            fn();
+        }
+        
+        std::function<void()> fn;
+    };
+    
+    void destructor_reentrancy_test()
+    {
+        fresh::event<void()> e;
+        
+        int calls = 0;
+        std::vector<fresh::connection<>> cnxns;
+        
+        auto survivor = e.connect([&]() { ++calls; });
+        cnxns.push_back(e.connect([]() {}));
+        cnxns.push_back(e.connect([]() {}));
+        
+        // Disconnecting its siblings.
+        auto guard = std::make_shared<on_destroy>();
+        guard->fn = [&]() { cnxns.clear(); };
+        
+        auto a = e.connect([guard]() {});
+        guard.reset();
+        a.disconnect();
+        
+        for (int i = 0; i < 100; i++)
+        {
+            e();
+        }
+        
+        assert(calls == 100);
+        
+        // Connecting to the same event, enough to grow its table.
+        guard = std::make_shared<on_destroy>();
+        guard->fn = [&]()
+        {
+            for (int i = 0; i < 64; i++)
+            {
+                cnxns.push_back(e.connect([&]() { calls += 1000; }));
+            }
+        };
+        
+        auto b = e.connect([guard]() {});
+        guard.reset();
+        b.disconnect();
+        
+        e();
+        assert(calls == 101 + 64 * 1000);
+        
+        // Disconnecting itself from within an emit, so the slot is destroyed
+        // when the emit finishes.
+        cnxns.clear();
+        calls = 0;
+        
+        guard = std::make_shared<on_destroy>();
+        guard->fn = [&]()
+        {
+            cnxns.clear();
+            cnxns.push_back(e.connect([&]() { calls += 1000; }));
+        };
+        
+        fresh::connection<> self;
+        self = e.connect([guard, &self]() { self.disconnect(); });
+        guard.reset();
+        
+        e();
+        e();
+        assert(calls == 2 + 1000);
+        
+        // And both, from a keyed event's slot.
+        fresh::keyed_event<int, void()> keyed;
+        
+        calls = 0;
+        cnxns.clear();
+        cnxns.push_back(keyed.connect(1, []() {}));
+        
+        guard = std::make_shared<on_destroy>();
+        guard->fn = [&]()
+        {
+            cnxns.clear();
+            cnxns.push_back(keyed.connect(1, [&]() { ++calls; }));
+            cnxns.push_back(keyed.connect(2, [&]() { ++calls; }));
+        };
+        
+        auto c = keyed.connect(1, [guard]() {});
+        guard.reset();
+        c.disconnect();
+        
+        keyed(1);
+        keyed(2);
+        assert(calls == 2);
+        
+        // Destroying the event itself, by disconnecting its last slot or a
+        // group of them.
+        auto owned = std::make_unique<fresh::event<void()>>();
+        
+        guard = std::make_shared<on_destroy>();
+        guard->fn = [&]() { owned.reset(); };
+        
+        auto d = owned->connect([guard]() {});
+        guard.reset();
+        d.disconnect();
+        
+        assert(!owned);
+        
+        auto ownedTs = std::make_unique<fresh::static_event<void(), 2, true>>();
+        fresh::connection_group<true> group;
+        
+        guard = std::make_shared<on_destroy>();
+        guard->fn = [&]() { ownedTs.reset(); };
+        
+        group.add(ownedTs->connect([guard]() {}));
+        group.add(ownedTs->connect([]() {}));
+        guard.reset();
+        group.disconnect_all();
+        
+        assert(!ownedTs);
+        
+        owned = std::make_unique<fresh::event<void()>>();
+        fresh::connection_group<> ownedGroup;
+        
+        guard = std::make_shared<on_destroy>();
+        guard->fn = [&]() { owned.reset(); };
+        
+        for (int i = 0; i < 3; i++)
+        {
+            ownedGroup.add(owned->connect([guard]() {}));
+        }
+        
+        guard.reset();
+        ownedGroup.disconnect_all();
+        
+        assert(!owned);
+    }
+    
+    void reentrancy_test()
+    {
+        fresh::event<void(), true> e;
+        
+        int calls = 0;
+        std::vector<fresh::connection<true>> cnxns;
+        
+        // Each slot replaces itself with a new one.
+        std::function<void()> replace = [&]()
+        {
+            ++calls;
+            cnxns.push_back(e.connect(replace));
+            cnxns.erase(cnxns.begin());
+        };
+        
+        cnxns.push_back(e.connect(replace));
+        
+        e();
+        e();
+        assert(calls == 2 && cnxns.size() == 1);
+        
+        // A slot which owns a connection to its own event disconnects it when
+        // it's reclaimed.
+        auto owned = std::make_shared<fresh::connection<true>>(e.connect([&]() { calls += 10; }));
+        
+        {
+            auto owner = e.connect([owned]() {});
+            owned.reset();
+        }
+        
+        cnxns.clear();
+        
+        e();
+        assert(calls == 2);
+        
+        destructor_reentrancy_test();
+    }
+    
+    size_t payload_allocations = 0;
+    
+    template <class T>
+    struct counting_allocator : std::allocator<T>
+    {
+        template <class U>
+        struct rebind
+        {
+            using other = counting_allocator<U>;
+        };
+        
+        counting_allocator() = default;
+        
+        template <class U>
+        counting_allocator(const counting_allocator<U>&)
+        {
+        }
+        
+        T* allocate(size_t n)
+        {
+            ++payload_allocations;
+            return std::allocator<T>::allocate(n);
+        }
+    };
+    
+    // Each slot taking the payload by value copies it once, however many
+    // layers the event passes it through, and emitting doesn't copy it.
+    template <bool ThreadSafe>
+    void forwarding_test()
+    {
+        using payload = std::vector<int, counting_allocator<int>>;
+        
+        fresh::event<void(payload), ThreadSafe> e;
+        size_t received = 0;
+        
+        auto cnxn1 = e.connect([&](payload p) { received += p.size(); });
+        auto cnxn2 = e.connect([&](payload p) { received += p.size(); });
+        auto cnxn3 = e.connect([&](const payload& p) { received += p.size(); });
+        
+        payload p(100);
+        size_t allocations = payload_allocations;
+        
+        e(p);
+        assert(payload_allocations == allocations + 3);
+        
+        // One more for the temporary.
+        e(payload(100));
+        assert(payload_allocations == allocations + 7);
+        assert(received == 600);
+    }
+    
+    struct quote
+    {
+        quote(int p) :
+            price(p)
+        {
+        }
+        
+        quote(const quote& other) :
+            price(other.price)
+        {
+            ++copies;
+        }
+        
+        int price;
+        
+        static int copies;
+    };
+    
+    int quote::copies = 0;
+    
+    void shared_payload_test()
+    {
+        fresh::event<void(const fresh::shared_payload<quote>&), true> e;
+        
+        fresh::work_stealing_pool pool(2);
+        e.set_parallel_dispatch(&pool, 4);
+        
+        std::atomic<int> total {0};
+        std::atomic<const quote*> seen {nullptr};
+        std::vector<fresh::connection<true>> cnxns;
+        
+        for (int i = 0; i < 8; i++)
+        {
+            cnxns.push_back(e.connect(
+                [&](const fresh::shared_payload<quote>& q)
+                {
+                    total += q->price;
+                    seen = q.get();
+                }));
+        }
+        
+        // A slot can take the value itself.
+        cnxns.push_back(e.connect([&](const quote& q) { total += q.price; }));
+        
+        auto payload = fresh::make_shared_payload<quote>(10);
+        
+        e(payload);
+        
+        assert(total == 90);
+        assert(seen == payload.get());
+        assert(quote::copies == 0 && payload.use_count() == 1);
+    }
+    
+    void keyed_event_test()
+    {
+        fresh::keyed_event<int, void(int)> e;
+        
+        int totals[3] = {};
+        std::vector<fresh::connection<>> cnxns;
+        
+        for (int id = 0; id < 3; id++)
+        {
+            cnxns.push_back(e.connect(id, [&totals, id](int v) { totals[id] += v; }));
+            cnxns.push_back(e.connect(id, [&totals, id](int v) { totals[id] += v; }));
+        }
+        
+        e(1, 5);
+        e(7, 5);
+        assert(totals[0] == 0 && totals[1] == 10 && totals[2] == 0);
+        
+        // Disconnecting every slot, including the one being called, from
+        // within a slot.
+        cnxns.push_back(e.connect(2, [&](int) { cnxns.clear(); }));
+        
+        e(2, 1);
+        e(2, 1);
+        e(1, 1);
+        assert(totals[1] == 10 && totals[2] == 2);
+        
+        fresh::keyed_event<std::string, int(int), true> ts;
+        
+        auto cnxn1 = ts.connect("a", [](int v) { return v; });
+        auto cnxn2 = ts.connect("b", [](int v) { return v * 2; });
+        auto cnxn3 = ts.connect("b", [](int v) { return v * 3; });
+        
+        assert((ts("b", 1) == std::vector<int>{ 2, 3 }));
+        
+        cnxn2.disconnect();
+        assert((ts("b", 1) == std::vector<int>{ 3 }));
+        
+        cnxn3.disconnect();
+        assert(ts("b", 1).empty());
+        assert((ts("a", 1) == std::vector<int>{ 1 }));
+        
+        // Enough keys to grow the index several times, then few enough to
+        // shrink it again.
+        fresh::keyed_event<int, int(), true> many;
+        std::vector<fresh::connection<true>> manyCnxns;
+        
+        for (int id = 0; id < 1000; id++)
+        {
+            manyCnxns.push_back(many.connect(id, [id]() { return id; }));
+        }
+        
+        for (int id = 0; id < 1000; id++)
+        {
+            assert((many(id) == std::vector<int>{ id }));
+        }
+        
+        for (int id = 0; id < 1000; id++)
+        {
+            if (id % 10 != 0)
+            {
+                manyCnxns[id].disconnect();
+            }
+        }
+        
+        for (int id = 0; id < 1000; id++)
+        {
+            assert(many(id).size() == (id % 10 == 0 ? 1 : 0));
+        }
+        
+        manyCnxns.clear();
+        assert(many(0).empty());
+        
+        manyCnxns.push_back(many.connect(5, []() { return 5; }));
+        assert((many(5) == std::vector<int>{ 5 }));
+    }
+    
+    void connection_group_test()
+    {
+        fresh::event<void(), true> ts;
+        fresh::event<void()> e;
+        
+        int calls = 0;
+        std::vector<std::function<void()>> fns(3, [&]() { ++calls; });
+        
+        fresh::connection_group<true> group;
+        ts.connect_many(fns.begin(), fns.end(), group);
+        
+        fresh::event<void(), true> other;
+        group.add(other.connect([&]() { calls += 10; }));
+        
+        // Only the group's connections are disconnected.
+        auto kept = ts.connect([&]() { calls += 100; });
+        
+        ts();
+        other();
+        assert(calls == 113 && group.size() == 4);
+        
+        group.disconnect_all();
+        assert(group.empty());
+        
+        ts();
+        other();
+        assert(calls == 213);
+        
+        // Connections to an event which no longer exists are skipped.
+        fresh::connection_group<> local;
+        
+        {
+            fresh::event<void()> temporary;
+            local.add(temporary.connect([]() {}));
+        }
+        
+        local.add(e.connect([&]() { ++calls; }));
+        local.add(e.connect([&]() { local.disconnect_all(); }));
+        
+        e();
+        e();
+        assert(calls == 214 && local.empty());
+    }
+    
+    void sharded_event_test()
+    {
+        fresh::sharded_event<int(int)> e(4);
+        assert(e.shard_count() == 4);
+        
+        // Each thread connects to its own shard.
+        std::vector<fresh::connection<true>> cnxns(4);
+        std::vector<std::thread> threads;
+        std::atomic<int> calls(0);
+        
+        for (int i = 0; i < 4; i++)
+        {
+            threads.emplace_back(
+                [&, i]()
+                {
+                    cnxns[i] = e.connect([&calls, i](int v) { ++calls; return v + i; });
+                });
+        }
+        
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        
+        auto results = e(10);
+        std::sort(results.begin(), results.end());
+        assert((results == std::vector<int>{ 10, 11, 12, 13 }));
+        
+        // Stopping in one shard stops the rest too.
+        calls = 0;
+        assert(e.combine(fresh::first_non_default<int>(), 1) != 0);
+        assert(calls == 1);
+        
+        cnxns[1].disconnect();
+        cnxns[3].disconnect();
+        
+        results = e(10);
+        std::sort(results.begin(), results.end());
+        assert((results == std::vector<int>{ 10, 12 }));
+        
+        fresh::sharded_event<void(int)> v(2);
+        int total = 0;
+        
+        auto cnxn1 = v.connect([&](int x) { total += x; });
+        auto cnxn2 = v.connect([&](int x) { total += x * 10; });
+        
+        v(1);
+        assert(total == 11);
+    }
+    
+    template <class Locking>
+    void locking_test()
+    {
+        fresh::event<int(int), true, std::allocator, fresh::sum<int>, Locking> e;
+        
+        auto cnxn1 = e.connect([](int v) { return v; });
+        auto cnxn2 = e.connect([](int v) { return v * 2; });
+        assert(e(1) == 3);
+        
+        cnxn1.disconnect();
+        assert(e(1) == 2);
+        
+        using attributes = fresh::property_attributes<fresh::copy, fresh::null_signal,
+            fresh::null_connection, true, Locking>;
+        
+        fresh::property<double, fresh::writable<attributes>> value = 0.0;
+        std::vector<std::thread> threads;
+        
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    for (int i = 0; i < 1000; i++)
+                    {
+                        value += 1.0;
+                    }
+                });
+        }
+        
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        
+        assert(value() == 4000.0);
+        
+        fresh::property<int, fresh::writable<fresh::basic_observable<fresh::copy, true, Locking>>>
+            observed = 0;
+        int changes = 0;
+        
+        auto cnxn3 = observed.connect([&]() { ++changes; });
+        observed = 5;
+        assert(changes == 1 && observed() == 5);
+    }
+    
+    void biased_locking_test()
+    {
+        auto before = fresh::bias_statistics();
+        
+        fresh::biased_mutex mutex;
+        int value = 0;
+        
+        for (int i = 0; i < 1000; i++)
+        {
+            std::lock_guard<fresh::biased_mutex> lock(mutex);
+            ++value;
+        }
+        
+        assert(mutex.biased() && !mutex.revoked());
+        
+        // A second thread revokes the bias, but first waits for the owner to
+        // unlock.
+        std::atomic<bool> locked(false);
+        
+        mutex.lock();
+        
+        std::thread other(
+            [&]()
+            {
+                std::lock_guard<fresh::biased_mutex> lock(mutex);
+                locked = true;
+                value += 1000;
+            });
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        assert(!locked);
+        
+        value += 1000;
+        mutex.unlock();
+        other.join();
+        
+        assert(locked && value == 3000 && mutex.revoked() && !mutex.biased());
+        
+        // From then on, the owner locks the mutex like everyone else.
+        std::vector<std::thread> threads;
+        
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    for (int i = 0; i < 1000; i++)
+                    {
+                        std::lock_guard<fresh::biased_mutex> lock(mutex);
+                        ++value;
+                    }
+                });
+        }
+        
+        for (int i = 0; i < 1000; i++)
+        {
+            std::lock_guard<fresh::biased_mutex> lock(mutex);
+            ++value;
+        }
+        
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        
+        assert(value == 8000);
+        
+        auto after = fresh::bias_statistics();
+        assert(after.biased > before.biased && after.revocations > before.revocations);
+    }
+    
+    // While the gate is closed, whoever locks a gated_mutex keeps it locked
+    // until the gate opens.
+    std::atomic<bool> gate_closed(false);
+    std::atomic<bool> gate_held(false);
+    
+    class gated_mutex
+    {
+    public:
+        
+        void lock()
+        {
+            _mutex.lock();
+            ++thread_locks;
+            
+            if (gate_closed)
+            {
+                gate_held = true;
+                
+                while (gate_closed)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        
+        void unlock()
+        {
+            _mutex.unlock();
+        }
+        
+    private:
+        
+        std::mutex _mutex;
+    };
+    
+    struct gated_locking
+    {
+        using mutex_type = gated_mutex;
+        using shared_mutex_type = gated_mutex;
+    };
+    
+    void realtime_test()
+    {
+        using event_type = fresh::realtime_event<int(int), std::allocator,
+            fresh::last_value<int>, gated_locking>;
+        
+        event_type e;
+        auto cnxn = e.connect([](int v) { return v + 1; });
+        
+        std::atomic<bool> stop(false);
+        std::atomic<bool> churned(false);
+        std::atomic<bool> emitted(false);
+        
+        std::thread churn(
+            [&]()
+            {
+                while (!stop)
+                {
+                    auto temporary = e.connect([](int v) { return v; });
+                }
+            });
+        
+        std::thread realtime(
+            [&]()
+            {
+                event_type::prepare_thread();
+                
+                size_t allocations = thread_allocations;
+                size_t locks = thread_locks;
+                
+                // Emits mustn't allocate or lock, even while slots come and go.
+                for (int i = 0; i < 10000; i++)
+                {
+                    e(i);
+                }
+                
+                churned = true;
+                
+                // Nor wait for a thread which holds the event's mutex.
+                while (!gate_held)
+                {
+                    std::this_thread::yield();
+                }
+                
+                assert(e(1) == 2);
+                assert(thread_allocations == allocations && thread_locks == locks);
+                
+                emitted = true;
+            });
+        
+        while (!churned)
+        {
+            std::this_thread::yield();
+        }
+        
+        stop = true;
+        churn.join();
+        
+        gate_closed = true;
+        
+        std::thread blocked([&]() { auto held = e.connect([](int v) { return v; }); });
+        
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        
+        while (!emitted && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+        
+        assert(emitted);
+        
+        gate_closed = false;
+        
+        blocked.join();
+        realtime.join();
+    }
+    
+    template <bool ThreadSafe>
+    void batch_test()
+    {
+        using event_type = fresh::event<void(int, double), ThreadSafe>;
+        
+        event_type e;
+        std::vector<std::tuple<int, double>> items = { { 1, 0.5 }, { 2, 1.0 }, { 3, 1.5 } };
+        
+        std::vector<int> calls;
+        std::vector<size_t> batches;
+        
+        auto cnxn1 = e.connect([&](int i, double) { calls.push_back(i); });
+        auto cnxn2 = e.connect_batch(
+            [&](const typename event_type::batch_type& batch)
+            {
+                batches.push_back(batch.size());
+                
+                for (auto& item : batch)
+                {
+                    calls.push_back(-std::get<0>(item));
+                }
+            });
+        
+        // Each slot gets the whole batch before the next one is called.
+        e.emit_batch(items);
+        
+        assert((calls == std::vector<int>{ 1, 2, 3, -1, -2, -3 }));
+        assert((batches == std::vector<size_t>{ 3 }));
+        
+        // Batch slots see a single emission as a batch of one.
+        calls.clear();
+        e(4, 2.0);
+        
+        assert((calls == std::vector<int>{ 4, -4 }));
+        assert((batches == std::vector<size_t>{ 3, 1 }));
+        
+        e.emit_batch(typename event_type::batch_type(nullptr, 0));
+        
+        assert((batches == std::vector<size_t>{ 3, 1, 0 }));
+        
+        // A slot which disconnects itself isn't given the rest of the batch.
+        calls.clear();
+        cnxn2.disconnect();
+        
+        typename event_type::connection_type cnxn3;
+        cnxn3 = e.connect(
+            [&](int i, double)
+            {
+                calls.push_back(i * 10);
+                cnxn3.disconnect();
+            });
+        
+        e.emit_batch(items);
+        
+        assert((calls == std::vector<int>{ 1, 2, 3, 10 }));
+    }
+    
+    void queued_connection_test()
+    {
+        fresh::event<void(int), true> e;
+        fresh::thread_context context;
+        
+        int total = 0;
+        std::thread::id caller;
+        
+        auto cnxn = e.connect(
+            [&](int v)
+            {
+                total += v;
+                caller = std::this_thread::get_id();
+            },
+            context);
+        
+        std::thread emitter([&]() { e(1); e(2); });
+        emitter.join();
+        
+        // Nothing's called until the owning thread processes its calls.
+        assert(total == 0);
+        assert(context.process_pending(1) == 1 && total == 1);
+        assert(context.process_pending() == 1 && total == 3);
+        assert(caller == std::this_thread::get_id());
+        
+        // Calls still pending when the slot is disconnected aren't made.
+        e(4);
+        cnxn.disconnect();
+        assert(context.process_pending() == 1 && total == 3);
+        
+        // A waiting thread is woken by an emit.
+        auto cnxn2 = e.connect([&](int v) { total += v; }, context);
+        
+        std::thread late([&]() { e(5); });
+        
+        while (total == 3)
+        {
+            context.wait_and_process(std::chrono::seconds(1));
+        }
+        
+        late.join();
+        assert(total == 8);
+    }
+    
+#if FRESH_COROUTINES
+    
+    struct task
+    {
+        struct promise_type
+        {
+            task get_return_object() { return {}; }
+            std::suspend_never initial_suspend() { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+    
+    task await_sum(fresh::event<void(int, int)>& e, int& result)
+    {
+        auto [a, b] = co_await e;
+        result = a + b;
+    }
+    
+    task await_on(fresh::event<void(std::string), true>& e, fresh::executor& exec,
+        std::string& result)
+    {
+        result = co_await fresh::next_emission(e, exec);
+    }
+    
+    task await_changes(fresh::property<int, fresh::writable<fresh::observable>>& p,
+        std::vector<int>& seen)
+    {
+        auto changes = p.changes();
+        
+        for (;;)
+        {
+            int v = co_await changes.next();
+            
+            if (v < 0)
+            {
+                co_return;
+            }
+            
+            seen.push_back(v);
+        }
+    }
+    
+    void coroutine_test()
+    {
+        fresh::event<void(int, int)> e;
+        int sum = 0;
+        
+        await_sum(e, sum);
+        e(1, 2);
+        e(3, 4);
+        assert(sum == 3);
+        
+        // Resumed on the executor, not on the emitting thread.
+        fresh::event<void(std::string), true> ts;
+        fresh::thread_context context;
+        std::string result;
+        
+        await_on(ts, context, result);
+        
+        std::thread emitter([&]() { ts("first"); ts("second"); });
+        emitter.join();
+        
+        assert(result.empty());
+        assert(context.process_pending() == 1 && result == "first");
+        
+        // A single slot queues every change, so none are missed while the
+        // coroutine's busy.
+        fresh::property<int, fresh::writable<fresh::observable>> p = 0;
+        std::vector<int> seen;
+        
+        await_changes(p, seen);
+        p = 1;
+        p = 2;
+        p = -1;
+        p = 3;
+        assert((seen == std::vector<int>{ 1, 2 }));
+    }
+    
+#endif
+    
+#if defined(__linux__)
+    
+    void shm_bridge_test()
+    {
+        using fn = void(int, double);
+        
+        auto ring = fresh::shm_ring::create_anonymous(
+            8, fresh::shm_publisher<fn>::record_type::size);
+        
+        // As another process would see it.
+        auto mapped = fresh::shm_ring::from_fd(dup(ring.fd()));
+        
+        fresh::event<fn, true> source;
+        fresh::event<fn, true> replica1;
+        fresh::event<fn, true> replica2;
+        
+        fresh::shm_publisher<fn> publisher(source, ring);
+        fresh::shm_receiver<fn> receiver1(mapped, replica1);
+        fresh::shm_receiver<fn> receiver2(mapped, replica2);
+        
+        double total1 = 0;
+        double total2 = 0;
+        
+        auto cnxn1 = replica1.connect([&](int i, double d) { total1 += i * d; });
+        auto cnxn2 = replica2.connect([&](int i, double d) { total2 += i * d; });
+        
+        source(2, 1.5);
+        source(3, 2.0);
+        
+        assert(receiver1.receive() == 2 && total1 == 9);
+        
+        // Each receiver has its own cursor.
+        source(1, 1.0);
+        
+        assert(receiver1.receive() == 1 && total1 == 10);
+        assert(receiver2.receive(std::chrono::milliseconds(10)) == 3 && total2 == 10);
+        assert(receiver2.receive(std::chrono::milliseconds(1)) == 0);
+        
+        // A receiver which falls more than a ring behind skips what it missed.
+        for (int i = 0; i < 20; i++)
+        {
+            source(1, 1.0);
+        }
+        
+        assert(receiver1.receive() == 8 && receiver1.lost() == 12);
+    }
+    
+#endif
+    
+#if defined(__unix__) || defined(__APPLE__)
+    
+    void emission_log_test()
+    {
+        using fn = void(int, double);
+        
+        char path[] = "/tmp/fresh_emission_logXXXXXX";
+        close(mkstemp(path));
+        
+        fresh::event<fn, true> source;
+        fresh::event<void(int)> other;
+        
+        {
+            auto log = fresh::emission_log::create(path, 1 << 20, 4096);
+            
+            fresh::emission_recorder<fn> recorder(source, log, 1);
+            fresh::emission_recorder<void(int), false> otherRecorder(other, log, 2);
+            
+            // Each thread appends to chunks of its own.
+            std::vector<std::thread> threads;
+            
+            for (int t = 0; t < 2; t++)
+            {
+                threads.emplace_back(
+                    [&, t]()
+                    {
+                        for (int i = 0; i < 1000; i++)
+                        {
+                            source(t * 10000 + i, i * 0.5);
+                        }
+                    });
+            }
+            
+            other(7);
+            
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            
+            assert(log.entries().size() == 2001 && log.dropped() == 0);
+        }
+        
+        // Replayed as another process would, from the file.
+        auto log = fresh::emission_log::open(path);
+        
+        fresh::event<fn> replica;
+        fresh::event<void(int)> otherReplica;
+        
+        int last[2] = { -1, -1 };
+        double total = 0;
+        int otherTotal = 0;
+        
+        auto cnxn1 = replica.connect(
+            [&](int i, double d)
+            {
+                // Each thread's emissions come back in the order it made them.
+                assert(i % 10000 > last[i / 10000]);
+                last[i / 10000] = i % 10000;
+                total += d;
+            });
+        
+        auto cnxn2 = otherReplica.connect([&](int i) { otherTotal += i; });
+        
+        fresh::emission_replayer replayer(log);
+        replayer.add(1, replica);
+        
+        assert(replayer.replay() == 2000);
+        assert(last[0] == 999 && last[1] == 999 && total == 2 * 249750 && otherTotal == 0);
+        
+        replayer.add(2, otherReplica);
+        
+        last[0] = last[1] = -1;
+        
+        assert(replayer.replay() == 2001 && otherTotal == 7);
+        
+        unlink(path);
+        
+        // Replaying at the original speed keeps the gaps between emissions.
+        auto timed = fresh::emission_log::create(path, 4096, 4096);
+        
+        {
+            fresh::emission_recorder<void(int), false> recorder(other, timed, 2);
+            
+            other(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            other(2);
+        }
+        
+        fresh::emission_replayer timedReplayer(timed);
+        timedReplayer.add(2, otherReplica);
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        assert(timedReplayer.replay(fresh::replay_speed::original) == 2);
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+        
+        // Once every chunk is claimed, emissions are dropped.
+        fresh::emission_recorder<void(int), false> recorder(other, timed, 2);
+        
+        for (int i = 0; i < 1000; i++)
+        {
+            other(i);
+        }
+        
+        assert(timed.entries().size() + timed.dropped() == 1002 && timed.dropped() > 0);
+        
+        unlink(path);
+        
+        // A thread appending to two logs in turn keeps a chunk in each, rather
+        // than claiming a new one every time it switches.
+        char otherPath[] = "/tmp/fresh_emission_logXXXXXX";
+        close(mkstemp(otherPath));
+        
+        {
+            auto first = fresh::emission_log::create(path, 3 * 4096, 4096);
+            auto second = fresh::emission_log::create(otherPath, 2 * 4096, 4096);
+            
+            for (int i = 0; i < 200; i++)
+            {
+                assert(first.append(1, &i, sizeof(i)) && second.append(2, &i, sizeof(i)));
+            }
+            
+            assert(first.entries().size() == 200 && first.dropped() == 0);
+            assert(second.entries().size() == 200 && second.dropped() == 0);
+        }
+        
+        unlink(otherPath);
+        
+        // Recording more to a reopened log carries on from its latest entry,
+        // without counting the time it spent closed.
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        
+        {
+            auto reopened = fresh::emission_log::open(path);
+            auto before = reopened.entries();
+            
+            int i = 200;
+            assert(reopened.append(3, &i, sizeof(i)));
+            
+            auto after = reopened.entries();
+            
+            assert(after.size() == before.size() + 1 && after.back().id == 3);
+            assert(after.back().time > before.back().time);
+            assert(after.back().time - before.back().time <
+                   (uint64_t)std::chrono::nanoseconds(std::chrono::milliseconds(50)).count());
+        }
+        
+        unlink(path);
+    }
+    
+#endif
+    
+    class counting_resource : public std::pmr::memory_resource
+    {
+    public:
+        
+        std::atomic<size_t> allocations {0};
+        std::atomic<size_t> outstanding {0};
+        
+    private:
+        
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocations;
+            outstanding += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            outstanding -= bytes;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+    
+    void allocator_test()
+    {
+        counting_resource resource;
+        
+        {
+            fresh::pmr::event<int(int), true> e(&resource);
+            
+            // Too big to be held inline by a delegate.
+            int big[16] = { 5 };
+            
+            auto cnxn1 = e.connect([big](int i) { return i + big[0]; });
+            auto cnxn2 = e.connect([](int i) { return i * 2; });
+            
+            assert(resource.allocations > 0);
+            
+            auto results = e(1);
+            
+            assert((results == std::pmr::vector<int>{ 6, 2 }));
+            assert(results.get_allocator().resource() == &resource);
+        }
+        
+        // The event reclaims its functions and snapshots when destroyed.
+        assert(resource.outstanding == 0);
+        
+        // Including those retired by another thread, which hasn't retired
+        // enough since to reclaim them itself.
+        {
+            std::atomic<int> step {0};
+            std::thread other;
+            
+            {
+                fresh::pmr::event<int(int), true> e(&resource);
+                
+                other = std::thread(
+                    [&]()
+                    {
+                        for (int i = 0; i < 4; i++)
+                        {
+                            auto cnxn = e.connect([](int i) { return i; });
+                        }
+                        
+                        step = 1;
+                        
+                        while (step != 2)
+                        {
+                            std::this_thread::yield();
+                        }
+                    });
+                
+                while (step != 1)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            
+            assert(resource.outstanding == 0);
+            
+            step = 2;
+            other.join();
+        }
+        
+        // A graph of events built in an arena, which would throw rather than
+        // fall back on the heap.
+        alignas(std::max_align_t) char buffer[64 * 1024];
+        
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                                  std::pmr::null_memory_resource());
+        
+        {
+            std::pmr::polymorphic_allocator<char> alloc(&arena);
+            std::deque<fresh::pmr::event<void(int)>> events;
+            std::vector<fresh::connection<>> cnxns;
+            
+            int sum = 0;
+            
+            for (int i = 0; i < 32; i++)
+            {
+                events.emplace_back(alloc);
+                cnxns.push_back(events.back().connect([&sum](int i) { sum += i; }));
+            }
+            
+            // A batch slot goes through the arena too, rather than the heap.
+            using batch_type = fresh::pmr::event<void(int)>::batch_type;
+            
+            int big[16] = { 10 };
+            size_t allocations = thread_allocations;
+            
+            auto batched = events.front().connect_batch(
+                [&sum, big](const batch_type& batch) { sum += big[0] * (int)batch.size(); });
+            
+            assert(thread_allocations == allocations);
+            
+            for (auto& e : events)
+            {
+                e(1);
+            }
+            
+            assert(sum == 32 + 10);
+        }
+    }
+}
 
 void event_test()
 {
@@ -22,4 +1807,40 @@ void event_test()
     cnxns.push_back(std::move(cnxn));
     
     e();
+    
+    connection_order_test();
+    snapshot_test();
+    delegate_test();
+    combiner_test();
+    async_event_test();
+    parallel_dispatch_test();
+    static_event_test();
+    connection_handle_test();
+    reentrancy_test();
+    forwarding_test<false>();
+    forwarding_test<true>();
+    shared_payload_test();
+    keyed_event_test();
+    queued_connection_test();
+    connection_group_test();
+    sharded_event_test();
+    locking_test<fresh::default_locking>();
+    locking_test<fresh::shared_mutex_locking>();
+    locking_test<fresh::spin_locking>();
+    locking_test<fresh::futex_locking>();
+    locking_test<fresh::biased_locking>();
+    biased_locking_test();
+    realtime_test();
+    batch_test<false>();
+    batch_test<true>();
+#if FRESH_COROUTINES
+    coroutine_test();
+#endif
+#if defined(__linux__)
+    shm_bridge_test();
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+    emission_log_test();
+#endif
+    allocator_test();
 }
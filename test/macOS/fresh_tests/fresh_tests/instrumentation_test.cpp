@@ -0,0 +1,377 @@
+//
+// instrumentation_test.cpp
+//
+//  Created by Vincent Tourangeau on 10/18/26.
+//  Copyright © 2026 Vincent Tourangeau. All rights reserved.
+//
+
+// The other test files don't define it, so their events, even those with the
+// same signatures as these, are different types which aren't instrumented.
+#define FRESH_EVENT_INSTRUMENTATION 1
+
+#include "event.hpp"
+#include "instrumentation.hpp"
+
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const fresh::event_report* find_report(const std::vector<fresh::event_report>& reports,
+                                           const void* address)
+    {
+        for (auto& report : reports)
+        {
+            if (report.address == address)
+            {
+                return &report;
+            }
+        }
+
+        return nullptr;
+    }
+
+    uint64_t histogram_total(const fresh::slot_report& slot, size_t from = 0)
+    {
+        uint64_t total = 0;
+
+        for (size_t b = from; b < fresh::slot_report::buckets; b++)
+        {
+            total += slot.histogram[b];
+        }
+
+        return total;
+    }
+
+    // Just enough of a JSON parser to check dump_json's output is well formed.
+    class json_checker
+    {
+    public:
+
+        json_checker(const std::string& text) :
+            _text(text)
+        {
+        }
+
+        bool valid()
+        {
+            return value() && (skip(), _pos == _text.size());
+        }
+
+    private:
+
+        void skip()
+        {
+            while (_pos < _text.size() && std::isspace((unsigned char)_text[_pos]))
+            {
+                ++_pos;
+            }
+        }
+
+        bool consume(char c)
+        {
+            skip();
+
+            if (_pos < _text.size() && _text[_pos] == c)
+            {
+                ++_pos;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool literal(const char* word)
+        {
+            std::string w(word);
+
+            if (_text.compare(_pos, w.size(), w) == 0)
+            {
+                _pos += w.size();
+                return true;
+            }
+
+            return false;
+        }
+
+        bool string()
+        {
+            if (!consume('"'))
+            {
+                return false;
+            }
+
+            while (_pos < _text.size() && _text[_pos] != '"')
+            {
+                _pos += _text[_pos] == '\\' ? 2 : 1;
+            }
+
+            return consume('"');
+        }
+
+        bool number()
+        {
+            size_t start = _pos;
+
+            while (_pos < _text.size() && std::isdigit((unsigned char)_text[_pos]))
+            {
+                ++_pos;
+            }
+
+            return _pos > start;
+        }
+
+        template <class Fn>
+        bool list(char close, Fn element)
+        {
+            if (consume(close))
+            {
+                return true;
+            }
+
+            do
+            {
+                if (!element())
+                {
+                    return false;
+                }
+            }
+            while (consume(','));
+
+            return consume(close);
+        }
+
+        bool value()
+        {
+            skip();
+
+            if (_pos >= _text.size())
+            {
+                return false;
+            }
+
+            switch (_text[_pos])
+            {
+                case '{':
+                    ++_pos;
+                    return list('}', [this]() { return string() && consume(':') && value(); });
+
+                case '[':
+                    ++_pos;
+                    return list(']', [this]() { return value(); });
+
+                case '"':
+                    return string();
+
+                default:
+                    return literal("true") || literal("false") || number();
+            }
+        }
+
+        const std::string&  _text;
+        size_t              _pos = 0;
+    };
+
+    void counts_test()
+    {
+        fresh::event<void(int)> e;
+        e.set_name("counted");
+
+        int sum = 0;
+
+        auto cnxn1 = e.connect([&](int i) { sum += i; });
+        auto cnxn2 = e.connect([&](int i) { sum += i * 10; });
+
+        e(1);
+        e(2);
+        e(3);
+
+        cnxn1.disconnect();
+        e(4);
+
+        assert(sum == 6 + 60 + 40);
+
+        auto reports = fresh::event_registry::instance().reports();
+        auto report = find_report(reports, &e);
+
+        assert(report);
+        assert(report->name == "counted");
+        assert(!report->thread_safe && !report->counts_only);
+        assert(report->emits == 4);
+        assert(report->connects == 2);
+        assert(report->disconnects == 1);
+        assert(report->subscribers == 1);
+        assert(report->memory >= sizeof(e));
+
+        // Only the connected slot is reported, and every call it took is in
+        // the histogram.
+        assert(report->slots.size() == 1);
+        assert(report->slots[0].calls == 4);
+        assert(histogram_total(report->slots[0]) == 4);
+
+        // A thread-safe event counts each slot call the same way.
+        fresh::event<int(), true> ts;
+        std::vector<fresh::connection<true>> cnxns;
+
+        for (int i = 0; i < 3; i++)
+        {
+            cnxns.push_back(ts.connect([i]() { return i; }));
+        }
+
+        assert(ts().size() == 3);
+
+        reports = fresh::event_registry::instance().reports();
+        report = find_report(reports, &ts);
+
+        assert(report && report->thread_safe);
+        assert(report->emits == 1 && report->connects == 3 && report->subscribers == 3);
+        assert(report->slots.size() == 3);
+
+        for (auto& slot : report->slots)
+        {
+            assert(slot.calls == 1 && histogram_total(slot) == 1);
+        }
+    }
+
+    void histogram_test()
+    {
+        fresh::event<void()> e;
+
+        auto cnxn = e.connect(
+            []() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+
+        e();
+        e();
+
+        auto reports = fresh::event_registry::instance().reports();
+        auto report = find_report(reports, &e);
+
+        // A millisecond is over 2^19 ns, so both calls are in bucket 19 or
+        // above.
+        assert(report && report->slots.size() == 1);
+        assert(report->slots[0].calls == 2);
+        assert(histogram_total(report->slots[0], 19) == 2);
+    }
+
+    void registry_test()
+    {
+        auto& registry = fresh::event_registry::instance();
+        size_t before = registry.reports().size();
+
+        {
+            fresh::event<void()> e1;
+            fresh::event<void(), true> e2;
+
+            auto reports = registry.reports();
+
+            assert(reports.size() == before + 2);
+            assert(find_report(reports, &e1) && find_report(reports, &e2));
+        }
+
+        assert(registry.reports().size() == before);
+    }
+
+    void other_thread_test()
+    {
+        fresh::event<void()> e;
+        fresh::event<void(), true> ts;
+
+        auto cnxn = e.connect([]() {});
+        auto tsCnxn = ts.connect([]() {});
+
+        e();
+        ts();
+
+        std::vector<fresh::event_report> reports;
+
+        std::thread reporter([&]() { reports = fresh::event_registry::instance().reports(); });
+        reporter.join();
+
+        // The non-thread-safe event's slots aren't looked at from another
+        // thread, but its counts are reported.
+        auto report = find_report(reports, &e);
+
+        assert(report && report->counts_only);
+        assert(report->emits == 1 && report->connects == 1);
+        assert(report->subscribers == 0 && report->slots.empty());
+
+        report = find_report(reports, &ts);
+
+        assert(report && !report->counts_only);
+        assert(report->subscribers == 1 && report->slots.size() == 1);
+    }
+
+    void dump_test()
+    {
+        auto& registry = fresh::event_registry::instance();
+
+        std::ostringstream empty;
+        registry.dump_json(empty);
+
+        assert(json_checker(empty.str()).valid());
+
+        fresh::event<void()> e;
+        e.set_name("dumped \"quoted\"");
+
+        auto cnxn = e.connect([]() {});
+
+        e();
+        e();
+
+        std::ostringstream json;
+        registry.dump_json(json);
+
+        auto text = json.str();
+
+        assert(json_checker(text).valid());
+        assert(text.find("\"name\": \"dumped \\\"quoted\\\"\"") != std::string::npos);
+        assert(text.find("\"emits\": 2, \"connects\": 1, \"disconnects\": 0") !=
+               std::string::npos);
+        assert(text.find("\"slots\": [{\"calls\": 2, \"histogram_ns\": {\"") !=
+               std::string::npos);
+
+        std::ostringstream plain;
+        registry.dump_text(plain);
+
+        std::istringstream lines(plain.str());
+        std::string line;
+        bool found = false;
+
+        while (std::getline(lines, line))
+        {
+            if (line.compare(0, 16, "dumped \"quoted\" ") == 0)
+            {
+                std::string counts;
+                std::string slot;
+
+                std::getline(lines, counts);
+                std::getline(lines, slot);
+
+                assert(counts == "  subscribers: 1, memory: " +
+                       std::to_string(find_report(registry.reports(), &e)->memory) +
+                       " bytes, emits: 2, connects: 1, disconnects: 0");
+                assert(slot.compare(0, 18, "  slot 0: 2 calls,") == 0);
+
+                found = true;
+            }
+        }
+
+        assert(found);
+    }
+}
+
+void instrumentation_test()
+{
+    counts_test();
+    histogram_test();
+    registry_test();
+    other_thread_test();
+    dump_test();
+}
@@ -10,13 +10,16 @@
 
 #include <fresh/property.hpp>
 
+#include <cstring>
 #include <memory>
 #include <thread>
 
 //import std.vector;
 #include <vector>
 
+extern void benchmark_test();
 extern void event_test();
+extern void instrumentation_test();
 
 using namespace std::literals;
 
@@ -162,6 +165,13 @@ int main(int argc, const char * argv[])
     //printf("f3: %f\n", a.f3());
     
     event_test();
+    instrumentation_test();
+    
+    // The benchmarks take a while, so they're only run when asked for.
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0)
+    {
+        benchmark_test();
+    }
     
     a.another_a = std::make_shared<A>();
     a.another_a = std::make_shared<A>();